@@ -1,103 +1,405 @@
+#include "decode.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
-#include <string>
-#include <vector>
+#include <mutex>
 
 #include "aes_crypt.h"
-#include "compress.h"
-#include "crypt.h"
-#include "decode_formatter.h"
-#include "effective_sink.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "token_hasher.h"
 #include "zstd_compress.h"
 
-#include "effective_msg.pb.h"
-
 using namespace logger;
 using namespace logger::crypt;
 using namespace logger::detail;
 
 std::unique_ptr<DecodeFormatter> decode_formatter;
-std::unique_ptr<Compression> decompress;
+thread_local std::unique_ptr<Compression> decompress;
+thread_local std::unordered_map<uint32_t, CallSiteInfo> call_sites;
+thread_local std::unordered_map<uint32_t, std::string> thread_names;
+thread_local std::unordered_map<uint32_t, std::unique_ptr<Compression>> dictionaries;
+std::function<void(const char* data, size_t size)> record_handler;
+DecodeFilter decode_filter;
+// LoadDictionary 加载的字典内容，工作线程据此创建各自的解压对象
+static std::vector<std::vector<char>> dictionary_data;
+static std::mutex dictionary_mutex;
 
-void DecodeFile(const std::string& input_file_path, const std::string& pri_key, const std::string& output_file_path);
-void AppendDataToFile(const std::string& file_path, const std::string& data);
-void DecodeChunkData(char* data,
-                     size_t size,
-                     const std::string& cli_pub_key,
-                     const std::string& svr_pri_key,
-                     std::string& output_data);
-void DecodeItemData(char* data, size_t size, Crypt* crypt, std::string& output_data);
-std::vector<char> ReadFile(const std::string& input_file_path);
+// (svr 私钥, cli 公钥) -> ECDH 共享密钥，所有文件、线程共享
+// 同一 sink 进程写出的 chunk 使用同一公钥，只需计算一次点乘
+static constexpr size_t kMaxSharedSecrets = 4096;
+static std::unordered_map<std::string, std::string> shared_secrets;
+static std::mutex shared_secrets_mutex;
 
-void DecodeFile(const std::string& input_file_path, const std::string& pri_key, const std::string& output_file_path) {
-  auto input_data = ReadFile(input_file_path);
-  if (input_data.size() < sizeof(ChunkHeader)) {
-    throw std::runtime_error("DecodeFile: input file is too small");
-    return;
+// 已扩展密钥的解密对象，解密有状态，因此每个线程一份，以共享密钥为键
+struct ChunkCiphers {
+  std::unique_ptr<AESCtrCrypt> ctr;  // v3
+  std::unique_ptr<AESCrypt> cbc;     // v1、v2
+};
+static thread_local std::unordered_map<std::string, ChunkCiphers> chunk_ciphers;
+
+// 解密、解压的中间结果，每个线程复用，容量增长到最大的块后不再分配
+static thread_local std::string decrypted_buf;
+static thread_local std::string decompressed_buf;
+
+OutputWriter::OutputWriter(const std::string& file_path, size_t flush_size) : flush_size_(flush_size) {
+  ofs_.open(file_path, std::ios::binary | std::ios::app);
+  if (!ofs_.is_open()) {
+    throw std::runtime_error("OutputWriter: open file failed, path = " + file_path);
   }
-  auto chunk_header = reinterpret_cast<ChunkHeader*>(input_data.data());
-  if (chunk_header->magic != ChunkHeader::kMagic) {
-    throw std::runtime_error("DecodeFile: invalid file magic");
+  buffer_.reserve(flush_size_ + flush_size_ / 4);
+}
+
+OutputWriter::~OutputWriter() {
+  Flush();
+}
+
+void OutputWriter::Flush() {
+  ofs_.write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+/// @brief 工作线程首次解码前按主线程加载的字典创建自己的解压对象
+static void PrepareWorkerThread() {
+  if (decompress) {
     return;
   }
+  decompress = std::make_unique<ZstdCompress>();
+  std::lock_guard<std::mutex> lock(dictionary_mutex);
+  for (const auto& dict : dictionary_data) {
+    auto dict_decompress = std::make_unique<ZstdCompress>();
+    uint32_t dict_id = dict_decompress->SetDictionary(dict.data(), dict.size());
+    dictionaries[dict_id] = std::move(dict_decompress);
+  }
+}
+
+/// @brief 获取 chunk 的 ECDH 共享密钥，未命中时计算并缓存
+/// @param chunk_header
+/// @param svr_pri_key
+/// @return
+static std::string GetSharedSecret(const ChunkHeader& chunk_header, const std::string& svr_pri_key) {
+  // 公钥为二进制数据，可能含有 0 字节，按固定长度读取
+  std::string cli_pub_key(chunk_header.pub_key, ChunkHeader::kPubKeySize);
+  std::string cache_key = svr_pri_key;
+  cache_key.push_back('\0');
+  cache_key.append(cli_pub_key);
+  {
+    std::lock_guard<std::mutex> lock(shared_secrets_mutex);
+    auto it = shared_secrets.find(cache_key);
+    if (it != shared_secrets.end()) {
+      return it->second;
+    }
+  }
+  // 点乘在锁外进行，不同公钥的 chunk 互不阻塞
+  std::string shared_secret = GenECDHSharedSecret(HexKeyToBinary(svr_pri_key), cli_pub_key);
+  std::lock_guard<std::mutex> lock(shared_secrets_mutex);
+  if (shared_secrets.size() >= kMaxSharedSecrets) {
+    shared_secrets.clear();
+  }
+  shared_secrets.emplace(std::move(cache_key), shared_secret);
+  return shared_secret;
+}
+
+/// @brief 获取当前线程中解密该 chunk 的对象，v3 的计数器已按 chunk 的 nonce 重置
+/// @param chunk_header
+/// @param svr_pri_key
+/// @return
+static Crypt* GetChunkCrypt(const ChunkHeader& chunk_header, const std::string& svr_pri_key) {
+  std::string shared_secret = GetSharedSecret(chunk_header, svr_pri_key);
+  if (chunk_ciphers.size() >= kMaxSharedSecrets && chunk_ciphers.count(shared_secret) == 0) {
+    chunk_ciphers.clear();
+  }
+  ChunkCiphers& ciphers = chunk_ciphers[shared_secret];
+  if (ChunkHeader::IsCtr(chunk_header.magic)) {
+    if (!ciphers.ctr) {
+      ciphers.ctr = std::make_unique<AESCtrCrypt>(shared_secret);
+    }
+    ciphers.ctr->Reset(chunk_header.nonce);
+    return ciphers.ctr.get();
+  }
+  if (!ciphers.cbc) {
+    ciphers.cbc = std::make_unique<AESCrypt>(shared_secret);
+  }
+  return ciphers.cbc.get();
+}
+
+bool DecodeFilter::MatchText(StringView text) const {
+  for (const auto& token : tokens) {
+    bool found = false;
+    for (size_t pos = text.find(token); pos != StringView::npos && !found; pos = text.find(token, pos + 1)) {
+      size_t end = pos + token.size();
+      found = (pos == 0 || !IsTokenChar(text[pos - 1])) && (end == text.size() || !IsTokenChar(text[end]));
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief 以 chunk 末尾的 Bloom 过滤器判断是否可能包含 decode_filter 中的全部词
+/// 只读取各 BlockHeader 找到过滤器，计算共享密钥但不解密，没有过滤器的 chunk 总是需要解码
+/// @param data ChunkHeader 之后的数据
+/// @param chunk_header
+/// @param svr_pri_key
+/// @return
+static bool ChunkMayContainTokens(const char* data, const ChunkHeader& chunk_header, const std::string& svr_pri_key) {
+  if (!ChunkHeader::IsCtr(chunk_header.magic)) {
+    return true;
+  }
+  size_t size = chunk_header.size;
+  size_t offset = chunk_header.magic == ChunkHeader::kMagicV4 ? sizeof(ChunkSummary) : 0;
+  BlockHeader block_header;
+  while (size - offset >= sizeof(block_header)) {
+    memcpy(&block_header, data + offset, sizeof(block_header));
+    offset += sizeof(block_header);
+    if (block_header.size > size - offset) {
+      return true;
+    }
+    if (block_header.magic == BlockHeader::kBloomMagic) {
+      TokenHasher hasher(GetSharedSecret(chunk_header, svr_pri_key));
+      hasher.Reset(chunk_header.nonce);
+      // 短词没有写入过滤器，只在解码后比较
+      for (const auto& token : decode_filter.tokens) {
+        if (token.size() >= kMinBloomTokenSize &&
+            !TokenBloomMayContain(data + offset, block_header.size, hasher.Hash(token.data(), token.size()))) {
+          return false;
+        }
+      }
+      return true;
+    }
+    offset += block_header.size;
+  }
+  return true;
+}
+
+/// @brief 只读取各 ChunkHeader，得到文件中全部 chunk 的位置
+/// @param data
+/// @param size
+/// @param error 遇到无效的 chunk 时记录原因，之前的 chunk 仍然返回
+/// @return
+std::vector<ChunkRef> ScanChunks(const char* data, size_t size, std::string* error) {
+  std::vector<ChunkRef> chunks;
   size_t offset = 0;
-  size_t file_size = input_data.size();
-  std::string output_data;
-  output_data.reserve(1024 * 1024);
-  while (offset < file_size) {
-    ChunkHeader* chunk_header = reinterpret_cast<ChunkHeader*>(input_data.data() + offset);
-    if (chunk_header->magic != ChunkHeader::kMagic) {
-      throw std::runtime_error("DecodeFile: invalid chunk magic");
-      return;
+  while (offset < size) {
+    if (size - offset < sizeof(ChunkHeader)) {
+      *error = "DecodeFile: truncated chunk header";
+      break;
+    }
+    // 映射中的 ChunkHeader 不保证对齐，拷贝后使用
+    ChunkRef chunk;
+    memcpy(&chunk.header, data + offset, sizeof(chunk.header));
+    if (!IsValidChunkMagic(chunk.header.magic)) {
+      *error = offset == 0 ? "DecodeFile: invalid file magic" : "DecodeFile: invalid chunk magic";
+      break;
     }
-    output_data.clear();
     offset += sizeof(ChunkHeader);
-    DecodeChunkData(input_data.data() + offset, chunk_header->size, std::string(chunk_header->pub_key), pri_key,
-                    output_data);
-    offset += chunk_header->size;
-    AppendDataToFile(output_file_path, output_data);
+    if (chunk.header.size > size - offset) {
+      *error = "DecodeFile: truncated chunk";
+      break;
+    }
+    if (chunk.header.magic == ChunkHeader::kMagicV4) {
+      if (chunk.header.size < sizeof(ChunkSummary)) {
+        *error = "DecodeFile: truncated chunk summary";
+        break;
+      }
+      memcpy(&chunk.summary, data + offset, sizeof(chunk.summary));
+    }
+    chunk.offset = offset;
+    chunks.push_back(chunk);
+    offset += chunk.header.size;
+  }
+  return chunks;
+}
+
+/// @brief 在线程池中解码各 chunk，按文件中的顺序写入输出
+/// 每个 chunk 独立解码，已提交的 chunk 数限制在线程数的 4 倍以内，内存占用不随文件增长
+/// @param input
+/// @param chunks
+/// @param pri_key
+/// @param output
+/// @param threads
+static void DecodeChunksParallel(MappedFile& input,
+                                 const std::vector<ChunkRef>& chunks,
+                                 const std::string& pri_key,
+                                 OutputWriter& output,
+                                 size_t threads) {
+  struct ChunkResult {
+    std::string output;
+    std::exception_ptr error;
+    bool done = false;
+  };
+  std::vector<ChunkResult> results(chunks.size());
+  std::mutex mutex;
+  std::condition_variable cond;
+  // 线程池析构时丢弃未开始的任务并等待正在执行的任务，出错提前返回时不会访问已释放的 results
+  ThreadPool pool(static_cast<uint32_t>(threads));
+  pool.Start();
+  size_t window = threads * 4;
+  size_t submitted = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    for (; submitted < chunks.size() && submitted < i + window; ++submitted) {
+      const ChunkRef* chunk = &chunks[submitted];
+      ChunkResult* result = &results[submitted];
+      auto task = [&input, &pri_key, &mutex, &cond, chunk, result]() {
+        try {
+          PrepareWorkerThread();
+          DecodeChunkData(input.Data() + chunk->offset, chunk->header, pri_key, result->output);
+        } catch (...) {
+          result->error = std::current_exception();
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          result->done = true;
+        }
+        cond.notify_all();
+      };
+      pool.RunTask(std::move(task));
+    }
+    ChunkResult& result = results[i];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&result]() { return result.done; });
+    }
+    if (result.error) {
+      std::rethrow_exception(result.error);
+    }
+    output.Buffer().append(result.output);
+    std::string().swap(result.output);
+    output.MaybeFlush();
+    input.Release(chunks[i].offset + chunks[i].header.size);
+  }
+}
+
+/// @brief 映射输入文件，逐个 chunk 原地解码，输出累积到一定大小后写入文件
+/// 已解码部分的页面随即释放，内存占用与文件大小无关
+/// @param input_file_path
+/// @param pri_key
+/// @param output_file_path
+/// @param threads
+void DecodeFile(const std::string& input_file_path,
+                const std::string& pri_key,
+                const std::string& output_file_path,
+                size_t threads) {
+  MappedFile input(input_file_path);
+  if (input.Size() < sizeof(ChunkHeader)) {
+    throw std::runtime_error("DecodeFile: input file is too small");
+  }
+  std::string error;
+  auto chunks = ScanChunks(input.Data(), input.Size(), &error);
+  // 先凭明文摘要排除 chunk，不计算密钥也不解密，剩余的 chunk 再以 Bloom 过滤器排除
+  if (decode_filter.IsActive()) {
+    size_t total = chunks.size();
+    const char* data = input.Data();
+    auto skip = [data, &pri_key](const ChunkRef& chunk) {
+      return !decode_filter.Match(chunk) ||
+             (!decode_filter.tokens.empty() && !ChunkMayContainTokens(data + chunk.offset, chunk.header, pri_key));
+    };
+    chunks.erase(std::remove_if(chunks.begin(), chunks.end(), skip), chunks.end());
+    // 统计信息输出到 stderr，不与输出到 stdout 的内容混在一起
+    std::cerr << "skip chunks " << total - chunks.size() << "/" << total << std::endl;
+  }
+  OutputWriter output(output_file_path);
+  if (threads > 1 && !record_handler && chunks.size() > 1) {
+    DecodeChunksParallel(input, chunks, pri_key, output, threads);
+  } else {
+    for (const auto& chunk : chunks) {
+      DecodeChunkData(input.Data() + chunk.offset, chunk.header, pri_key, output.Buffer());
+      output.MaybeFlush();
+      input.Release(chunk.offset + chunk.header.size);
+    }
+  }
+  // 无效 chunk 之前的内容照常输出
+  if (!error.empty()) {
+    throw std::runtime_error(error);
   }
 }
 
-void AppendDataToFile(const std::string& file_path, const std::string& data) {
-  std::ofstream ofs(file_path, std::ios::binary | std::ios::app);
-  ofs.write(data.data(), data.size());
+/// @brief 同一文件中可能同时存在不同版本的 chunk
+/// @param magic
+/// @return
+bool IsValidChunkMagic(uint64_t magic) {
+  return magic == ChunkHeader::kMagic || magic == ChunkHeader::kMagicV2 || ChunkHeader::IsCtr(magic);
 }
 
 /// @brief 将 Chunk 中的数据解析到 output_data 中
-/// Chunk 中包含多个 Item
-/// 解析过程：使用 svr 私钥和 cli 公钥生成 aes 的加解密 密钥
-/// 得到密钥后，分别解析每一个 Item
+/// v1 的 Chunk 中包含多个 Item，v2 的 Chunk 中包含多个 Block
+/// 解析过程：使用 svr 私钥和 cli 公钥生成 aes 的加解密 密钥，同一公钥的密钥与解密对象只生成一次
+/// 得到密钥后，分别解析每一个 Item 或 Block，v3 的 Block 使用 AES-CTR 解密，v4 先跳过 ChunkSummary
 /// @param data
-/// @param size
-/// @param cli_pub_key
+/// @param chunk_header
 /// @param svr_pri_key
 /// @param output_data
-void DecodeChunkData(char* data,
-                     size_t size,
-                     const std::string& cli_pub_key,
+void DecodeChunkData(const char* data,
+                     const ChunkHeader& chunk_header,
                      const std::string& svr_pri_key,
                      std::string& output_data) {
-  std::cout << "decode chunk " << size << std::endl;
-  std::string svr_pri_key_bin = HexKeyToBinary(svr_pri_key);
-  std::string shared_secret = GenECDHSharedSecret(svr_pri_key_bin, cli_pub_key);
-  std::unique_ptr<Crypt> crypt = std::make_unique<AESCrypt>(shared_secret);
+  size_t size = chunk_header.size;
+  uint64_t magic = chunk_header.magic;
+  Crypt* crypt = GetChunkCrypt(chunk_header, svr_pri_key);
+  // 每个 chunk 都会重新写入其引用的调用点、线程名称信息
+  call_sites.clear();
+  thread_names.clear();
   size_t offset = 0;
-  size_t count = 0;
+  if (magic == ChunkHeader::kMagicV2 || ChunkHeader::IsCtr(magic)) {
+    if (magic == ChunkHeader::kMagicV4) {
+      offset = sizeof(ChunkSummary);
+    }
+    Compression* block_decompress = decompress.get();
+    if (ChunkHeader::IsCtr(magic) && chunk_header.dict_id != 0) {
+      auto it = dictionaries.find(chunk_header.dict_id);
+      if (it == dictionaries.end()) {
+        throw std::runtime_error("DecodeChunkData: missing dictionary " + std::to_string(chunk_header.dict_id));
+      }
+      block_decompress = it->second.get();
+    }
+    while (offset < size) {
+      BlockHeader block_header;
+      if (size - offset < sizeof(block_header)) {
+        throw std::runtime_error("DecodeChunkData: truncated block header");
+      }
+      memcpy(&block_header, data + offset, sizeof(block_header));
+      if (block_header.magic != BlockHeader::kMagic && block_header.magic != BlockHeader::kBloomMagic) {
+        throw std::runtime_error("DecodeChunkData: invalid block magic");
+      }
+      offset += sizeof(BlockHeader);
+      if (block_header.size > size - offset) {
+        throw std::runtime_error("DecodeChunkData: truncated block");
+      }
+      if (block_header.magic == BlockHeader::kBloomMagic) {
+        offset += block_header.size;
+        continue;
+      }
+      DecodeBlockData(data + offset, block_header.size, crypt, block_decompress, output_data);
+      offset += block_header.size;
+    }
+    return;
+  }
   while (offset < size) {
-    ++count;
-    if (count % 1000 == 0) {
-      std::cout << "decode item:" << count << std::endl;
+    ItemHeader item_header;
+    if (size - offset < sizeof(item_header)) {
+      throw std::runtime_error("DecodeChunkData: truncated item header");
+    }
+    memcpy(&item_header, data + offset, sizeof(item_header));
+    offset += sizeof(ItemHeader);
+    if (item_header.size > size - offset) {
+      throw std::runtime_error("DecodeChunkData: truncated item");
     }
-    ItemHeader* item_header = reinterpret_cast<ItemHeader*>(data + offset);
-    if (item_header->magic != ItemHeader::kMagic) {
+    if (item_header.magic == ItemHeader::kMetaMagic) {
+      DecodeMetaData(data + offset, item_header.size, crypt);
+      offset += item_header.size;
+      continue;
+    }
+    if (item_header.magic != ItemHeader::kMagic) {
       throw std::runtime_error("DecodeChunkData: invalid item magic");
       return;
     }
-    offset += sizeof(ItemHeader);
-    DecodeItemData(data + offset, item_header->size, crypt.get(), output_data);
-    offset += item_header->size;
-    output_data.push_back('\n');
+    DecodeItemData(data + offset, item_header.size, crypt, output_data);
+    offset += item_header.size;
   }
 }
 
@@ -106,42 +408,145 @@ void DecodeChunkData(char* data,
 /// @param size
 /// @param crypt
 /// @param output_data
-void DecodeItemData(char* data, size_t size, Crypt* crypt, std::string& output_data) {
-  std::string decrypted = crypt->Decrypt(data, size);
-  std::string decompressed = decompress->Decompress(decrypted.data(), decrypted.size());
-  EffectiveMsg msg;
-  msg.ParseFromString(decompressed);
-  std::string formatter_logger;
-  decode_formatter->Format(msg, formatter_logger);
-  output_data.append(formatter_logger);
+void DecodeItemData(const char* data, size_t size, Crypt* crypt, std::string& output_data) {
+  decrypted_buf.clear();
+  crypt->DecryptTo(data, size, decrypted_buf);
+  decompressed_buf.clear();
+  decompress->DecompressTo(decrypted_buf.data(), decrypted_buf.size(), decompressed_buf);
+  if (FormatRecord(decompressed_buf.data(), decompressed_buf.size(), output_data)) {
+    output_data.push_back('\n');
+  }
+}
+
+/// @brief 解析 Item 中的调用点、线程名称信息，流程 原始数据->解密->解压->保存到 call_sites、thread_names
+/// @param data
+/// @param size
+/// @param crypt
+void DecodeMetaData(const char* data, size_t size, Crypt* crypt) {
+  decrypted_buf.clear();
+  crypt->DecryptTo(data, size, decrypted_buf);
+  decompressed_buf.clear();
+  decompress->DecompressTo(decrypted_buf.data(), decrypted_buf.size(), decompressed_buf);
+  ParseMeta(decompressed_buf.data(), decompressed_buf.size());
+}
+
+/// @brief 解析 Block 中的数据，流程 原始数据->解密->解压->逐条格式化或保存元数据
+/// @param data
+/// @param size
+/// @param crypt
+/// @param block_decompress 与 chunk 所用字典对应的解压对象
+/// @param output_data
+void DecodeBlockData(const char* data,
+                     size_t size,
+                     Crypt* crypt,
+                     Compression* block_decompress,
+                     std::string& output_data) {
+  decrypted_buf.clear();
+  crypt->DecryptTo(data, size, decrypted_buf);
+  // 写入端压缩失败的块为空块，仅占用一个 seq
+  if (decrypted_buf.empty()) {
+    return;
+  }
+  decompressed_buf.clear();
+  if (!block_decompress->DecompressBlockTo(decrypted_buf.data(), decrypted_buf.size(), decompressed_buf)) {
+    throw std::runtime_error("DecodeBlockData: decompress failed");
+  }
+  const char* ptr = decompressed_buf.data();
+  const char* end = ptr + decompressed_buf.size();
+  StringView record;
+  bool is_meta = false;
+  while (ptr < end) {
+    if (!ReadRecordFrame(ptr, end, &record, &is_meta)) {
+      throw std::runtime_error("DecodeBlockData: invalid record frame");
+    }
+    if (is_meta) {
+      ParseMeta(record.data(), record.size());
+      continue;
+    }
+    if (FormatRecord(record.data(), record.size(), output_data)) {
+      output_data.push_back('\n');
+    }
+  }
 }
 
-/// @brief 从文件中读取全部字符，将其保存到字符数组中
+/// @brief 将一条序列化后的 EffectiveMsg 格式化后写入缓存
+/// 以 MsgView 引用原始数据与调用点信息，直接格式化到 output_data，不分配内存
+/// @param data
+/// @param size
+/// @param output_data
+/// @return 是否写入了 output_data，不满足 decode_filter 的日志不写入
+bool FormatRecord(const char* data, size_t size, std::string& output_data) {
+  if (record_handler) {
+    record_handler(data, size);
+    return false;
+  }
+  // 与 ParseFromArray 一致，不完整的数据也格式化已解析的字段
+  MsgView msg;
+  ParseMsgView(data, size, &msg);
+  // 匹配的 chunk 中仍可能有范围外的日志
+  if (!decode_filter.Match(msg.timestamp, msg.level) ||
+      (!decode_filter.tokens.empty() && !decode_filter.MatchText(msg.log_info))) {
+    return false;
+  }
+  // 只记录了调用点 id 的日志，从调用点信息中还原位置
+  if (msg.site_id != 0) {
+    auto it = call_sites.find(msg.site_id);
+    if (it != call_sites.end()) {
+      msg.line = it->second.line();
+      msg.file_name = it->second.file_name();
+      msg.func_name = it->second.func_name();
+    }
+  }
+  if (msg.thread_name_id != 0) {
+    auto it = thread_names.find(msg.thread_name_id);
+    if (it != thread_names.end()) {
+      msg.thread_name = it->second;
+    }
+  }
+  decode_formatter->Format(msg, output_data);
+  return true;
+}
+
+/// @brief 保存 LogMeta 中的调用点、线程名称信息
+/// @param data
+/// @param size
+void ParseMeta(const char* data, size_t size) {
+  LogMeta meta;
+  meta.ParseFromArray(data, static_cast<int>(size));
+  for (const auto& site : meta.sites()) {
+    call_sites[site.id()] = site;
+  }
+  for (const auto& thread : meta.threads()) {
+    thread_names[thread.id()] = thread.name();
+  }
+}
+
+/// @brief 加载 train_dict 生成的字典，之后可以解码使用该字典的 chunk
+/// @param dict_file_path
+/// @return 字典 id
+uint32_t LoadDictionary(const std::string& dict_file_path) {
+  auto dict = ReadFile(dict_file_path);
+  auto dict_decompress = std::make_unique<ZstdCompress>();
+  uint32_t dict_id = dict_decompress->SetDictionary(dict.data(), dict.size());
+  if (dict_id == 0) {
+    throw std::runtime_error("LoadDictionary: invalid dictionary " + dict_file_path);
+  }
+  dictionaries[dict_id] = std::move(dict_decompress);
+  std::lock_guard<std::mutex> lock(dictionary_mutex);
+  dictionary_data.push_back(std::move(dict));
+  return dict_id;
+}
+
+/// @brief 从文件中读取全部字符，将其保存到字符数组中，只用于字典等小文件
 /// @param input_file_path
 /// @return
 std::vector<char> ReadFile(const std::string& input_file_path) {
-  std::ifstream file(input_file_path, std::ios::binary);
+  std::ifstream file(input_file_path, std::ios::binary | std::ios::ate);
   if (!file.is_open()) {
     throw std::runtime_error("ReadFile: open file failed!");
   }
-  std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<char> buffer(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
   return buffer;
 }
-
-int main() {
-  std::string input_file_path = "/home/axyz/usr/logger/logger/example/build/logger/loggerdemo_20250516151845.log";
-  std::string pri_key = "FAA5BBE9017C96BF641D19D0144661885E831B5DDF52539EF1AB4790C05E665E";
-  std::filesystem::path path(input_file_path);
-  std::string file_name = path.filename();
-  std::string output_file_path = "/home/axyz/usr/logger/logger/example/build/logger_decode/" + file_name;
-  try {
-    decode_formatter = std::make_unique<DecodeFormatter>();
-    decode_formatter->SetPattern("[%l][%D:%S][%p:%t][%F:%f:%#]%v");
-    decompress = std::make_unique<ZstdCompress>();
-    DecodeFile(input_file_path, pri_key, output_file_path);
-  } catch (const std::exception& e) {
-    std::cerr << "Decode failed:" << e.what() << std::endl;
-    return 1;
-  }
-  return 0;
-}
\ No newline at end of file
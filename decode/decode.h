@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compress.h"
+#include "crypt.h"
+#include "decode_formatter.h"
+#include "effective_sink.h"
+#include "token_bloom.h"
+
+#include "effective_msg.pb.h"
+
+extern std::unique_ptr<DecodeFormatter> decode_formatter;
+// 解压对象与当前 chunk 的状态每个线程一份，并行解码的工作线程在首次使用时按主线程的设置创建
+extern thread_local std::unique_ptr<logger::Compression> decompress;
+// 当前 chunk 中的调用点信息，id -> CallSiteInfo
+extern thread_local std::unordered_map<uint32_t, CallSiteInfo> call_sites;
+extern thread_local std::unordered_map<uint32_t, std::string> thread_names;
+// 已加载的 zstd 字典，字典 id -> 使用该字典的解压对象
+extern thread_local std::unordered_map<uint32_t, std::unique_ptr<logger::Compression>> dictionaries;
+// 若设置，每条日志解密、解压后的原始数据(序列化后的 EffectiveMsg)交给该函数处理，不再格式化
+// 设置后只能串行解码，保证按文件中的顺序调用
+extern std::function<void(const char* data, size_t size)> record_handler;
+
+// 文件中一个 chunk 的位置
+struct ChunkRef {
+  size_t offset;  // ChunkHeader 之后的数据在文件中的偏移
+  logger::detail::ChunkHeader header;
+  logger::detail::ChunkSummary summary;  // 仅 v4 有效
+};
+
+/// @brief 按时间范围、等级与日志内容中的词筛选日志
+/// v4 chunk 根据明文的 ChunkSummary 判断时间与等级，带有 Bloom 过滤器的 chunk 根据过滤器判断词，不匹配时不解密
+struct DecodeFilter {
+  int64_t from = INT64_MIN;         // 毫秒，包含
+  int64_t to = INT64_MAX;           // 毫秒，包含
+  uint32_t levels = UINT32_MAX;     // 需要的日志等级，第 level 位为 1
+  std::vector<std::string> tokens;  // 日志内容需要包含的词，按完整的词匹配
+
+  bool IsActive() const noexcept {
+    return from != INT64_MIN || to != INT64_MAX || levels != UINT32_MAX || !tokens.empty();
+  }
+
+  /// @brief chunk 中是否可能有需要的日志，v4 之前的 chunk 没有摘要，总是需要解码
+  /// @param chunk
+  /// @return
+  bool Match(const ChunkRef& chunk) const noexcept {
+    if (chunk.header.magic != logger::detail::ChunkHeader::kMagicV4) {
+      return true;
+    }
+    const auto& summary = chunk.summary;
+    return summary.count != 0 && summary.max_timestamp >= from && summary.min_timestamp <= to &&
+           (summary.levels & levels) != 0;
+  }
+
+  bool Match(int64_t timestamp, int32_t level) const noexcept {
+    return timestamp >= from && timestamp <= to && level >= 0 && level < 32 && ((levels >> level) & 1) != 0;
+  }
+
+  /// @brief 以 ForEachToken 切分 text，判断是否包含全部 tokens
+  /// @param text
+  /// @return
+  bool MatchText(logger::StringView text) const;
+};
+// 解码时使用的筛选条件，默认输出全部日志
+extern DecodeFilter decode_filter;
+
+/// @brief 解码结果的输出文件，只打开一次，缓冲区累积到 flush_size 后整体写入
+class OutputWriter {
+ public:
+  /// @brief 以追加方式打开文件
+  /// @param file_path
+  /// @param flush_size
+  explicit OutputWriter(const std::string& file_path, size_t flush_size = 4 * 1024 * 1024);
+  ~OutputWriter();
+
+  /// @brief 待写入的数据，解码结果直接追加到其中
+  /// @return
+  std::string& Buffer() noexcept { return buffer_; }
+
+  /// @brief 缓冲区达到 flush_size 时写入文件
+  void MaybeFlush() {
+    if (buffer_.size() >= flush_size_) {
+      Flush();
+    }
+  }
+
+  void Flush();
+
+ private:
+  std::ofstream ofs_;
+  std::string buffer_;
+  size_t flush_size_;
+};
+
+/// @brief 解码日志文件，结果追加到输出文件
+/// @param input_file_path
+/// @param pri_key
+/// @param output_file_path
+/// @param threads 大于 1 时各 chunk 在线程池中并行解码，仍按文件中的顺序输出
+void DecodeFile(const std::string& input_file_path,
+                const std::string& pri_key,
+                const std::string& output_file_path,
+                size_t threads = 1);
+std::vector<ChunkRef> ScanChunks(const char* data, size_t size, std::string* error);
+void DecodeChunkData(const char* data,
+                     const logger::detail::ChunkHeader& chunk_header,
+                     const std::string& svr_pri_key,
+                     std::string& output_data);
+void DecodeItemData(const char* data, size_t size, logger::crypt::Crypt* crypt, std::string& output_data);
+void DecodeMetaData(const char* data, size_t size, logger::crypt::Crypt* crypt);
+void DecodeBlockData(const char* data,
+                     size_t size,
+                     logger::crypt::Crypt* crypt,
+                     logger::Compression* block_decompress,
+                     std::string& output_data);
+bool FormatRecord(const char* data, size_t size, std::string& output_data);
+void ParseMeta(const char* data, size_t size);
+bool IsValidChunkMagic(uint64_t magic);
+uint32_t LoadDictionary(const std::string& dict_file_path);
+std::vector<char> ReadFile(const std::string& input_file_path);
@@ -1,19 +1,19 @@
+#include <charconv>
 #include <chrono>
 #include <cstring>
 #include <ctime>
-#include <iomanip>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
 #include "decode_formatter.h"
+#include "sys_util.h"
 
 class FlagFormatter {
  public:
   FlagFormatter() = default;
   virtual ~FlagFormatter() = default;
-  virtual void Format(const EffectiveMsg& flag, std::string& dest) = 0;
+  virtual void Format(const MsgView& flag, std::string& dest) = 0;
 };
 
 static const std::vector<std::string> LOG_LEVEL = {"V", "D", "I", "W", "E", "F"};
@@ -25,8 +25,8 @@ class LogLevelFormatter final : public FlagFormatter {
  public:
   LogLevelFormatter() = default;
   ~LogLevelFormatter() = default;
-  void Format(const EffectiveMsg& flag, std::string& dest) override {
-    auto index = flag.level();
+  void Format(const MsgView& flag, std::string& dest) override {
+    auto index = flag.level;
     if (0 <= index && index <= 5) {
       dest.append(LOG_LEVEL[index]);
     } else {
@@ -35,22 +35,43 @@ class LogLevelFormatter final : public FlagFormatter {
   }
 };
 
+/// @brief 追加十进制整数，不经过临时字符串
+template <typename T>
+static void AppendNumber(T value, std::string& dest) {
+  char buf[24];
+  auto result = std::to_chars(buf, buf + sizeof(buf), value);
+  dest.append(buf, result.ptr - buf);
+}
+
 std::string MillisecondsToDateString(long long milliseconds) {
   std::chrono::system_clock::time_point tp =
       std::chrono::system_clock::time_point(std::chrono::milliseconds(milliseconds));
   std::time_t time_tt = std::chrono::system_clock::to_time_t(tp);
-  std::tm* timeinfo = std::localtime(&time_tt);
-  std::ostringstream oss;
-  oss << std::put_time(timeinfo, "%Y-%m-%d %H:%M:%S");
-  return oss.str();
+  // 并行解码时多个线程同时格式化，不能使用返回静态缓冲区的 std::localtime
+  std::tm timeinfo;
+  LocalTime(&timeinfo, &time_tt);
+  char buf[32];
+  size_t size = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+  return std::string(buf, size);
 }
 
 class TimestampDateFormatter final : public FlagFormatter {
  public:
   TimestampDateFormatter() = default;
   ~TimestampDateFormatter() = default;
-  void Format(const EffectiveMsg& flag, std::string& dest) override {
-    dest.append(MillisecondsToDateString(flag.timestamp()));
+  void Format(const MsgView& flag, std::string& dest) override {
+    // 相邻日志大多在同一秒内，每个线程缓存最近一秒的结果
+    static thread_local long long last_second = -1;
+    static thread_local std::string last_date;
+    long long second = flag.timestamp / 1000;
+    if (flag.timestamp < 0 && flag.timestamp % 1000 != 0) {
+      --second;
+    }
+    if (second != last_second) {
+      last_date = MillisecondsToDateString(second * 1000);
+      last_second = second;
+    }
+    dest.append(last_date);
   }
 };
 
@@ -58,8 +79,8 @@ class TimestampSecondsFormatter final : public FlagFormatter {
  public:
   TimestampSecondsFormatter() = default;
   ~TimestampSecondsFormatter() = default;
-  void Format(const EffectiveMsg& flag, std::string& dest) override {
-    dest.append(std::to_string(flag.timestamp() / 1000));
+  void Format(const MsgView& flag, std::string& dest) override {
+    AppendNumber(flag.timestamp / 1000, dest);
   }
 };
 
@@ -67,14 +88,21 @@ class TimestampMillisecondsFormatter final : public FlagFormatter {
  public:
   TimestampMillisecondsFormatter() = default;
   ~TimestampMillisecondsFormatter() = default;
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(std::to_string(flag.timestamp())); }
+  void Format(const MsgView& flag, std::string& dest) override { AppendNumber(flag.timestamp, dest); }
 };
 
 class ThreadIdFormatter final : public FlagFormatter {
  public:
   ThreadIdFormatter() = default;
   ~ThreadIdFormatter() = default;
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(std::to_string(flag.tid())); }
+  void Format(const MsgView& flag, std::string& dest) override { AppendNumber(flag.tid, dest); }
+};
+
+class ThreadNameFormatter final : public FlagFormatter {
+ public:
+  ThreadNameFormatter() = default;
+  ~ThreadNameFormatter() = default;
+  void Format(const MsgView& flag, std::string& dest) override { dest.append(flag.thread_name); }
 };
 
 class ProcessIdFormatter final : public FlagFormatter {
@@ -82,7 +110,7 @@ class ProcessIdFormatter final : public FlagFormatter {
   ProcessIdFormatter() = default;
   ~ProcessIdFormatter() override = default;
 
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(std::to_string(flag.pid())); }
+  void Format(const MsgView& flag, std::string& dest) override { AppendNumber(flag.pid, dest); }
 };
 
 class LineFormatter final : public FlagFormatter {
@@ -90,7 +118,7 @@ class LineFormatter final : public FlagFormatter {
   LineFormatter() = default;
   ~LineFormatter() = default;
 
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(std::to_string(flag.line())); }
+  void Format(const MsgView& flag, std::string& dest) override { AppendNumber(flag.line, dest); }
 };
 
 class FileNameFormatter final : public FlagFormatter {
@@ -98,7 +126,7 @@ class FileNameFormatter final : public FlagFormatter {
   FileNameFormatter() = default;
   ~FileNameFormatter() = default;
 
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(flag.file_name()); }
+  void Format(const MsgView& flag, std::string& dest) override { dest.append(flag.file_name); }
 };
 
 class FuncNameFormatter final : public FlagFormatter {
@@ -106,7 +134,7 @@ class FuncNameFormatter final : public FlagFormatter {
   FuncNameFormatter() = default;
   ~FuncNameFormatter() = default;
 
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(flag.func_name()); }
+  void Format(const MsgView& flag, std::string& dest) override { dest.append(flag.func_name); }
 };
 
 class LogInfoFormatter final : public FlagFormatter {
@@ -114,7 +142,7 @@ class LogInfoFormatter final : public FlagFormatter {
   LogInfoFormatter() = default;
   ~LogInfoFormatter() = default;
 
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(flag.log_info()); }
+  void Format(const MsgView& flag, std::string& dest) override { dest.append(flag.log_info); }
 };
 
 class AggregateFormatter final : public FlagFormatter {
@@ -122,7 +150,7 @@ class AggregateFormatter final : public FlagFormatter {
   AggregateFormatter() = default;
   ~AggregateFormatter() override = default;
   void AddChar(char ch) { str_.push_back(ch); }
-  void Format(const EffectiveMsg& flag, std::string& dest) override { dest.append(str_); }
+  void Format(const MsgView& flag, std::string& dest) override { dest.append(str_); }
 
  private:
   std::string str_;
@@ -137,7 +165,7 @@ void ParsePattern(const std::string& pattern) {
   flag_formatters_.clear();
   auto end = pattern.end();
   for (auto it = pattern.begin(); it != end; ++it) {
-    // 若遇到 % 则表示接下来会遇到 l、D、S、p、t、F、f、#、v
+    // 若遇到 % 则表示接下来会遇到 l、D、S、p、t、n、F、f、#、v
     if (*it == '%') {
       if (str_formatter) {
         flag_formatters_.push_back(std::move(str_formatter));
@@ -146,7 +174,7 @@ void ParsePattern(const std::string& pattern) {
       if (it == end) {
         break;
       }
-      // 由于 % 后面是 l、D、S、p、t、F、f、#、v
+      // 由于 % 后面是 l、D、S、p、t、n、F、f、#、v
       // 因此需要添加对应的 formatter
       HandleFlag(*it);
     } else {
@@ -182,6 +210,9 @@ void HandleFlag(char flag) {
     case 't':
       flag_formatters_.push_back(std::make_unique<ThreadIdFormatter>());
       break;
+    case 'n':
+      flag_formatters_.push_back(std::make_unique<ThreadNameFormatter>());
+      break;
     case '#':
       flag_formatters_.push_back(std::make_unique<LineFormatter>());
       break;
@@ -208,34 +239,36 @@ void DecodeFormatter::SetPattern(const std::string& pattern) {
   ParsePattern(pattern);
 }
 
-std::string DefaultPatternMsg(const EffectiveMsg& msg) {
-  std::string output_string;
-  output_string.append("[");
-  output_string.append(std::to_string(msg.level()));
-  output_string.append("][");
-  output_string.append(std::to_string(msg.timestamp()));
-  output_string.append("][");
-  output_string.append(std::to_string(msg.pid()));
-  output_string.append(":");
-  output_string.append(std::to_string(msg.tid()));
-  output_string.append("][");
-  output_string.append(msg.file_name());
-  output_string.append(":");
-  output_string.append(msg.func_name());
-  output_string.append(":");
-  output_string.append(std::to_string(msg.line()));
-  output_string.append("]");
-  output_string.append(msg.log_info());
-  return output_string;
+static void DefaultPatternMsg(const MsgView& msg, std::string& dest) {
+  dest.append("[");
+  AppendNumber(msg.level, dest);
+  dest.append("][");
+  AppendNumber(msg.timestamp, dest);
+  dest.append("][");
+  AppendNumber(msg.pid, dest);
+  dest.append(":");
+  AppendNumber(msg.tid, dest);
+  dest.append("][");
+  dest.append(msg.file_name);
+  dest.append(":");
+  dest.append(msg.func_name);
+  dest.append(":");
+  AppendNumber(msg.line, dest);
+  dest.append("]");
+  dest.append(msg.log_info);
 }
 
 void DecodeFormatter::Format(const EffectiveMsg& msg, std::string& dest) {
+  Format(MsgView(msg), dest);
+}
+
+void DecodeFormatter::Format(const MsgView& msg, std::string& dest) {
   if (!flag_formatters_.empty()) {
     for (auto& formatter : flag_formatters_) {
       formatter->Format(msg, dest);
     }
   } else {
-    dest.append(DefaultPatternMsg(msg));
+    DefaultPatternMsg(msg, dest);
   }
   dest.append("\n");
 }
\ No newline at end of file
@@ -3,9 +3,13 @@
 #include <string>
 #include "decode_formatter.h"
 #include "effective_msg.pb.h"
+#include "msg_view.h"
 
 class DecodeFormatter {
  public:
   void SetPattern(const std::string& pattern);
   void Format(const EffectiveMsg& msg, std::string& dest);
+
+  /// @brief 直接追加到 dest，可在多个线程中同时调用
+  void Format(const MsgView& msg, std::string& dest);
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#include "decode.h"
+#include "zstd_compress.h"
+
+using namespace logger;
+
+/// @brief 解析时间参数，纯数字为毫秒时间戳，否则为本地时间 "YYYY-mm-dd HH:MM:SS"
+/// @param value
+/// @param timestamp
+/// @return
+static bool ParseTime(const std::string& value, int64_t* timestamp) {
+  if (!value.empty() && value.find_first_not_of("0123456789") == std::string::npos) {
+    *timestamp = std::stoll(value);
+    return true;
+  }
+  std::tm tm{};
+  if (sscanf(value.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+             &tm.tm_sec) != 6) {
+    return false;
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  tm.tm_isdst = -1;
+  *timestamp = static_cast<int64_t>(mktime(&tm)) * 1000;
+  return true;
+}
+
+/// @brief 解析等级参数，输出该等级及更高等级的日志，可使用 V D I W E F 或对应的数字
+/// @param value
+/// @param levels
+/// @return
+static bool ParseLevel(const std::string& value, uint32_t* levels) {
+  static const std::string kLevels = "VDIWEF";
+  if (value.size() != 1) {
+    return false;
+  }
+  size_t level = kLevels.find(static_cast<char>(toupper(value[0])));
+  if (level == std::string::npos) {
+    if (value[0] < '0' || value[0] > '5') {
+      return false;
+    }
+    level = value[0] - '0';
+  }
+  *levels = UINT32_MAX << level;
+  return true;
+}
+
+/// @brief 用法：test [--from=TIME] [--to=TIME] [--level=L] [--grep=WORDS] [log_file]
+/// 指定筛选条件时，时间范围或等级不匹配、Bloom 过滤器中没有全部词的 chunk 直接跳过，不解密、不解压
+int main(int argc, char** argv) {
+  std::string input_file_path = "/home/axyz/usr/logger/logger/example/build/logger/loggerdemo_20250516151845.log";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value = arg.substr(arg.find('=') + 1);
+    bool ok = true;
+    if (arg.rfind("--from=", 0) == 0) {
+      ok = ParseTime(value, &decode_filter.from);
+    } else if (arg.rfind("--to=", 0) == 0) {
+      ok = ParseTime(value, &decode_filter.to);
+    } else if (arg.rfind("--level=", 0) == 0) {
+      ok = ParseLevel(value, &decode_filter.levels);
+    } else if (arg.rfind("--grep=", 0) == 0) {
+      ForEachToken(value, [](StringView token) { decode_filter.tokens.emplace_back(token); });
+    } else if (arg.rfind("--", 0) != 0) {
+      input_file_path = arg;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "usage: " << argv[0] << " [--from=TIME] [--to=TIME] [--level=V|D|I|W|E|F] [--grep=WORDS] [log_file]"
+                << std::endl;
+      std::cerr << "TIME: milliseconds since epoch or \"YYYY-mm-dd HH:MM:SS\" in local time" << std::endl;
+      std::cerr << "WORDS: records whose message contains all of the words" << std::endl;
+      return 1;
+    }
+  }
+  std::string pri_key = "FAA5BBE9017C96BF641D19D0144661885E831B5DDF52539EF1AB4790C05E665E";
+  std::filesystem::path path(input_file_path);
+  std::string file_name = path.filename();
+  std::string output_file_path = "/home/axyz/usr/logger/logger/example/build/logger_decode/" + file_name;
+  // 使用字典压缩的日志需要对应的字典，目录中的 .dict 文件都会被加载
+  std::filesystem::path dict_dir = "/home/axyz/usr/logger/logger/example/build/logger_dict";
+  try {
+    decode_formatter = std::make_unique<DecodeFormatter>();
+    decode_formatter->SetPattern("[%l][%D:%S][%p:%t][%F:%f:%#]%v");
+    decompress = std::make_unique<ZstdCompress>();
+    if (std::filesystem::exists(dict_dir)) {
+      for (auto& p : std::filesystem::directory_iterator(dict_dir)) {
+        if (p.path().extension() == ".dict") {
+          LoadDictionary(p.path().string());
+        }
+      }
+    }
+    // 各 chunk 独立解码，使用全部核心并行
+    DecodeFile(input_file_path, pri_key, output_file_path, std::max(1u, std::thread::hardware_concurrency()));
+  } catch (const std::exception& e) {
+    std::cerr << "Decode failed:" << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
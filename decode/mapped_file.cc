@@ -0,0 +1,51 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdexcept>
+
+#include "defer.h"
+#include "sys_util.h"
+
+MappedFile::MappedFile(const std::string& file_path) {
+  int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw std::runtime_error("MappedFile: open file failed, path = " + file_path);
+  }
+  LOG_DEFER {
+    close(fd);
+  };
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    throw std::runtime_error("MappedFile: stat file failed, path = " + file_path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ == 0) {
+    return;
+  }
+  void* handle = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (handle == MAP_FAILED) {
+    throw std::runtime_error("MappedFile: mmap failed, path = " + file_path);
+  }
+  // 解码从前向后访问，加大预读并在访问后尽快回收
+  madvise(handle, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(handle);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+void MappedFile::Release(size_t offset) {
+  size_t page_size = GetPageSize();
+  size_t end = offset / page_size * page_size;
+  if (!data_ || end <= released_) {
+    return;
+  }
+  madvise(const_cast<char*>(data_) + released_, end - released_, MADV_DONTNEED);
+  released_ = end;
+}
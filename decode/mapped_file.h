@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// @brief 以只读方式映射整个输入文件，按顺序访问时由内核预读，已处理的部分可以释放
+class MappedFile {
+ public:
+  /// @brief 打开并映射文件，失败时抛出异常
+  /// @param file_path
+  explicit MappedFile(const std::string& file_path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* Data() const noexcept { return data_; }
+
+  size_t Size() const noexcept { return size_; }
+
+  /// @brief 释放 [0, offset) 中已处理完的页面，使常驻内存不随文件大小增长
+  /// @param offset
+  void Release(size_t offset);
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t released_ = 0;  // 已释放的字节数，按页对齐
+};
@@ -0,0 +1,111 @@
+#include "msg_view.h"
+
+using logger::StringView;
+
+MsgView::MsgView(const EffectiveMsg& msg)
+    : level(msg.level()),
+      timestamp(msg.timestamp()),
+      pid(msg.pid()),
+      tid(msg.tid()),
+      line(msg.line()),
+      file_name(msg.file_name()),
+      func_name(msg.func_name()),
+      log_info(msg.log_info()),
+      site_id(msg.site_id()),
+      thread_name_id(msg.thread_name_id()),
+      thread_name(msg.thread_name()) {}
+
+static bool ReadVarint(const char*& ptr, const char* end, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (ptr == end) {
+      return false;
+    }
+    auto byte = static_cast<uint8_t>(*ptr++);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ParseMsgView(const char* data, size_t size, MsgView* view) {
+  // wire type: 0 varint，1 定长 8 字节，2 长度前缀，5 定长 4 字节
+  const char* ptr = data;
+  const char* end = data + size;
+  while (ptr < end) {
+    uint64_t tag = 0;
+    if (!ReadVarint(ptr, end, &tag)) {
+      return false;
+    }
+    uint32_t field = static_cast<uint32_t>(tag >> 3);
+    uint32_t wire_type = static_cast<uint32_t>(tag & 7);
+    uint64_t value = 0;
+    StringView bytes;
+    switch (wire_type) {
+      case 0:
+        if (!ReadVarint(ptr, end, &value)) {
+          return false;
+        }
+        break;
+      case 1:
+      case 5: {
+        size_t width = wire_type == 1 ? 8 : 4;
+        if (static_cast<size_t>(end - ptr) < width) {
+          return false;
+        }
+        ptr += width;
+        continue;
+      }
+      case 2:
+        if (!ReadVarint(ptr, end, &value) || value > static_cast<uint64_t>(end - ptr)) {
+          return false;
+        }
+        bytes = StringView(ptr, value);
+        ptr += value;
+        break;
+      default:
+        return false;
+    }
+    // 负数的 int32 编码为 10 字节的 varint，取低 32 位即可还原
+    switch (field) {
+      case EffectiveMsg::kLevelFieldNumber:
+        view->level = static_cast<int32_t>(value);
+        break;
+      case EffectiveMsg::kTimestampFieldNumber:
+        view->timestamp = static_cast<int64_t>(value);
+        break;
+      case EffectiveMsg::kPidFieldNumber:
+        view->pid = static_cast<int32_t>(value);
+        break;
+      case EffectiveMsg::kTidFieldNumber:
+        view->tid = static_cast<int32_t>(value);
+        break;
+      case EffectiveMsg::kLineFieldNumber:
+        view->line = static_cast<int32_t>(value);
+        break;
+      case EffectiveMsg::kFileNameFieldNumber:
+        view->file_name = bytes;
+        break;
+      case EffectiveMsg::kFuncNameFieldNumber:
+        view->func_name = bytes;
+        break;
+      case EffectiveMsg::kLogInfoFieldNumber:
+        view->log_info = bytes;
+        break;
+      case EffectiveMsg::kSiteIdFieldNumber:
+        view->site_id = static_cast<uint32_t>(value);
+        break;
+      case EffectiveMsg::kThreadNameIdFieldNumber:
+        view->thread_name_id = static_cast<uint32_t>(value);
+        break;
+      case EffectiveMsg::kThreadNameFieldNumber:
+        view->thread_name = bytes;
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include "log_common.h"
+
+#include "effective_msg.pb.h"
+
+/// @brief EffectiveMsg 的只读视图，字符串字段指向序列化数据或调用点信息，解析时不分配内存
+struct MsgView {
+  int32_t level = 0;
+  int64_t timestamp = 0;
+  int32_t pid = 0;
+  int32_t tid = 0;
+  int32_t line = 0;
+  logger::StringView file_name;
+  logger::StringView func_name;
+  logger::StringView log_info;
+  uint32_t site_id = 0;
+  uint32_t thread_name_id = 0;
+  logger::StringView thread_name;
+
+  MsgView() = default;
+
+  /// @brief 引用 msg 中的字段，msg 需要比视图存活更久
+  /// @param msg
+  explicit MsgView(const EffectiveMsg& msg);
+};
+
+/// @brief 按 protobuf 编码规则直接解析序列化后的 EffectiveMsg，未知字段跳过
+/// @param data
+/// @param size
+/// @param view 数据不完整时保留已解析的字段
+/// @return 数据不完整时返回 false
+bool ParseMsgView(const char* data, size_t size, MsgView* view);
@@ -0,0 +1,76 @@
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "decode.h"
+#include "effective_sink.h"
+#include "zstd_compress.h"
+
+using namespace logger;
+
+static const std::string kPubKey =
+    "04827405069030E26A211C973C8710E6FBE79B5CAA364AC111FB171311902277537F8852EADD17EB339EB7CD0BA2490A58CDED2C702DFC1E"
+    "FC7EDB544B869F039C";
+static const std::string kPriKey = "FAA5BBE9017C96BF641D19D0144661885E831B5DDF52539EF1AB4790C05E665E";
+static const std::filesystem::path kDir = "filter_test";
+static constexpr int64_t kTime = 1700000000000;
+
+/// @brief 以指定的时间范围解码 log_file，返回输出的日志内容
+/// @param log_file
+/// @param from
+/// @param to
+/// @return 以空格分隔
+static std::string DecodeRange(const std::string& log_file, int64_t from, int64_t to) {
+  std::string output_file = (kDir / "decoded.txt").string();
+  std::filesystem::remove(output_file);
+  decode_filter = DecodeFilter();
+  decode_filter.from = from;
+  decode_filter.to = to;
+  DecodeFile(log_file, kPriKey, output_file);
+  std::ifstream ifs(output_file);
+  std::string messages;
+  std::string message;
+  while (ifs >> message) {
+    messages += messages.empty() ? message : " " + message;
+  }
+  return messages;
+}
+
+// 时间恰好等于 --from/--to 的日志应当输出，chunk 摘要与逐条筛选都按闭区间比较
+int main() {
+  std::filesystem::remove_all(kDir);
+  {
+    EffectiveSink::Conf conf;
+    conf.dir = kDir;
+    conf.prefix = "filter";
+    conf.pub_key = kPubKey;
+    auto sink = std::make_shared<EffectiveSink>(conf);
+    const char* messages[] = {"before", "at", "after"};
+    for (int i = 0; i < 3; ++i) {
+      LogMsg msg(LogLevel::kInfo, messages[i]);
+      msg.wall_ms = kTime - 1 + i;
+      sink->Log(msg);
+    }
+    sink->Flush();
+  }
+  std::string log_file;
+  for (auto& p : std::filesystem::directory_iterator(kDir)) {
+    if (p.path().extension() == ".log") {
+      log_file = p.path().string();
+    }
+  }
+  assert(!log_file.empty());
+
+  decode_formatter = std::make_unique<DecodeFormatter>();
+  decode_formatter->SetPattern("%v");
+  decompress = std::make_unique<ZstdCompress>();
+  assert(DecodeRange(log_file, kTime, kTime) == "at");
+  assert(DecodeRange(log_file, kTime + 1, INT64_MAX) == "after");
+  assert(DecodeRange(log_file, INT64_MIN, kTime - 1) == "before");
+  assert(DecodeRange(log_file, kTime - 1, kTime + 1) == "before at after");
+  assert(DecodeRange(log_file, kTime + 2, INT64_MAX).empty());
+  std::filesystem::remove_all(kDir);
+  std::cout << "DecodeFilter 边界测试通过" << std::endl;
+  return 0;
+}
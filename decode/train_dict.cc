@@ -0,0 +1,42 @@
+#include <fstream>
+#include <iostream>
+
+#include "decode.h"
+#include "zstd_compress.h"
+
+using namespace logger;
+
+/// @brief 从已有的日志文件中解出每条日志的原始数据作为样本，训练 zstd 字典
+/// 用法：train_dict <svr_pri_key> <dict_kb> <output.dict> <log_file>...
+/// 生成的字典通过 EffectiveSink::Conf::dict_path 使用，解码时放入字典目录
+/// 单条日志较短，字典一般取 4~16KB，过大的字典在小块上反而会降低压缩率
+int main(int argc, char** argv) {
+  if (argc < 5) {
+    std::cerr << "usage: " << argv[0] << " <svr_pri_key> <dict_kb> <output.dict> <log_file>..." << std::endl;
+    return 1;
+  }
+  std::string pri_key = argv[1];
+  size_t dict_size = std::stoul(argv[2]) * 1024;
+  std::string dict_file_path = argv[3];
+  std::vector<std::string> samples;
+  try {
+    decode_formatter = std::make_unique<DecodeFormatter>();
+    decompress = std::make_unique<ZstdCompress>();
+    record_handler = [&samples](const char* data, size_t size) { samples.emplace_back(data, size); };
+    for (int i = 4; i < argc; ++i) {
+      DecodeFile(argv[i], pri_key, "/dev/null");
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Collect samples failed:" << e.what() << std::endl;
+    return 1;
+  }
+  std::string dict = ZstdCompress::TrainDictionary(samples, dict_size);
+  if (dict.empty()) {
+    std::cerr << "Train dictionary failed, samples = " << samples.size() << std::endl;
+    return 1;
+  }
+  std::ofstream ofs(dict_file_path, std::ios::binary);
+  ofs.write(dict.data(), dict.size());
+  std::cout << "samples = " << samples.size() << ", dictionary size = " << dict.size() << std::endl;
+  return 0;
+}
@@ -0,0 +1,24 @@
+#include "call_site.h"
+
+namespace logger {
+CallSiteRegistry& CallSiteRegistry::Instance() {
+  static CallSiteRegistry instance;
+  return instance;
+}
+
+uint32_t CallSiteRegistry::Register(const SourceLocation& loc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sites_.push_back(loc);
+  uint32_t id = static_cast<uint32_t>(sites_.size());
+  sites_.back().site_id = id;
+  return id;
+}
+
+SourceLocation CallSiteRegistry::Get(uint32_t id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id == 0 || id > sites_.size()) {
+    return SourceLocation{};
+  }
+  return sites_[id - 1];
+}
+}  // namespace logger
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "log_common.h"
+
+namespace logger {
+/// @brief 静态调用点注册表：每个日志宏调用点在首次执行时注册一次，
+/// 之后日志只携带调用点 id，文件名、函数名、行号由 sink 在 cache 中单独记录一次
+class CallSiteRegistry {
+ public:
+  CallSiteRegistry(const CallSiteRegistry&) = delete;
+  CallSiteRegistry& operator=(const CallSiteRegistry&) = delete;
+
+  static CallSiteRegistry& Instance();
+
+  /// @brief 注册调用点，loc 中的字符串需要具有静态生命周期
+  /// @param loc
+  /// @return 调用点 id，从 1 开始
+  uint32_t Register(const SourceLocation& loc);
+
+  /// @brief 获取调用点信息，id 不存在时返回空的 SourceLocation
+  /// @param id
+  /// @return
+  SourceLocation Get(uint32_t id) const;
+
+ private:
+  CallSiteRegistry() = default;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<SourceLocation> sites_;
+};
+
+/// @brief 供日志宏使用：只在首次执行时去掉路径并注册
+/// @param file_name
+/// @param line
+/// @param func_name
+/// @return 带有 site_id 的 SourceLocation
+inline SourceLocation RegisterCallSite(StringView file_name, int32_t line, StringView func_name) {
+  SourceLocation loc(file_name, line, func_name);
+  loc.site_id = CallSiteRegistry::Instance().Register(loc);
+  return loc;
+}
+}  // namespace logger
@@ -14,6 +14,54 @@ class Compression {
 
   virtual std::string Decompress(const void* data, size_t size) = 0;
 
+  /// @brief 同 Decompress，结果追加到 output 末尾，output 已有的容量可以复用
+  /// @param data
+  /// @param size
+  /// @param output
+  /// @return 失败返回 false
+  virtual bool DecompressTo(const void* data, size_t size, std::string& output) {
+    std::string decompressed = Decompress(data, size);
+    output.append(decompressed);
+    return !decompressed.empty() || size == 0;
+  }
+
   virtual void ResetStream() = 0;
+
+  /// @brief 将 input 压缩为独立的一帧，不依赖流式压缩的上下文
+  /// @param input
+  /// @param input_size
+  /// @param output
+  /// @param output_size 不小于 CompressedBound(input_size)
+  /// @return 压缩后的大小，失败返回 0
+  virtual size_t CompressBlock(const void* input, size_t input_size, void* output, size_t output_size) = 0;
+
+  /// @brief 解压 CompressBlock 生成的一帧
+  /// @param data
+  /// @param size
+  /// @return 失败返回空字符串
+  virtual std::string DecompressBlock(const void* data, size_t size) = 0;
+
+  /// @brief 同 DecompressBlock，结果追加到 output 末尾
+  /// @param data
+  /// @param size
+  /// @param output
+  /// @return 失败返回 false
+  virtual bool DecompressBlockTo(const void* data, size_t size, std::string& output) {
+    std::string decompressed = DecompressBlock(data, size);
+    output.append(decompressed);
+    return !decompressed.empty();
+  }
+
+  /// @brief 设置 CompressBlock/DecompressBlock 使用的字典
+  /// @param dict
+  /// @param size
+  /// @return 字典 id，不支持或加载失败时返回 0
+  virtual uint32_t SetDictionary(const void* dict, size_t size) = 0;
+
+  /// @brief 设置之后 CompressBlock 使用的压缩等级，超出范围时取最接近的合法值
+  /// @param level
+  virtual void SetLevel(int level) = 0;
+
+  virtual int GetLevel() const = 0;
 };
 }  // namespace logger
\ No newline at end of file
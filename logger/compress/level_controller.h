@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace logger {
+/// @brief 根据写入压力调整压缩等级：压力大时降低等级(直至负数的快速等级)，空闲时逐步恢复
+/// 压力取以下两者的较大值：
+/// 1. 压缩耗时占评估周期的比例 / cpu_budget；
+/// 2. 积压比例(0~1)，即暂存缓冲区中尚未处理的数据占容量的比例；
+class LevelController {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  struct Conf {
+    int min_level = -5;                       // 压力最大时的等级
+    int max_level = 5;                        // 空闲时的等级
+    double cpu_budget = 0.5;                  // 压缩耗时占写入线程时间的上限
+    std::chrono::milliseconds interval{100};  // 评估周期
+  };
+
+  explicit LevelController(Conf conf) : conf_(conf), level_(conf.max_level), window_start_(clock::now()) {}
+
+  int Level() const noexcept { return level_; }
+
+  /// @brief 每压缩一个块调用一次，评估周期结束时调整等级
+  /// @param compress_time 本次压缩耗时
+  /// @param backlog 当前积压比例
+  /// @param now
+  /// @return 等级是否改变
+  bool Update(clock::duration compress_time, double backlog, clock::time_point now) {
+    busy_ += compress_time;
+    backlog_ = std::max(backlog_, backlog);
+    auto elapsed = now - window_start_;
+    if (elapsed < conf_.interval) {
+      return false;
+    }
+    double busy_ratio = static_cast<double>(busy_.count()) / static_cast<double>(elapsed.count());
+    double pressure = std::max(busy_ratio / conf_.cpu_budget, backlog_);
+    window_start_ = now;
+    busy_ = clock::duration::zero();
+    backlog_ = 0;
+
+    int level = level_;
+    if (pressure >= 1.0) {
+      // 快速下降，尽快消化突发流量
+      level = std::max(conf_.min_level, level - 2);
+    } else if (pressure < 0.5) {
+      level = std::min(conf_.max_level, level + 1);
+    }
+    // zstd 中等级 0 表示默认等级，跳过
+    if (level == 0) {
+      level = level < level_ ? -1 : 1;
+    }
+    if (level == level_) {
+      return false;
+    }
+    level_ = level;
+    return true;
+  }
+
+ private:
+  Conf conf_;
+  int level_;
+  clock::time_point window_start_;
+  clock::duration busy_{clock::duration::zero()};
+  double backlog_ = 0;
+};
+}  // namespace logger
@@ -99,6 +99,25 @@ void ZlibCompress::ResetUncompressStream_() {
 }
 
 size_t ZlibCompress::CompressedBound(size_t input_size) {
-  return input_size + 10;
+  // CompressBlock 使用 compress2，需要 zlib 给出的上限
+  return compressBound(static_cast<uLong>(input_size)) + 10;
+}
+
+size_t ZlibCompress::CompressBlock(const void* input, size_t input_size, void* output, size_t output_size) {
+  if (!input || !output) {
+    return 0;
+  }
+  uLongf dest_len = static_cast<uLongf>(output_size);
+  int ret = compress2((Bytef*)output, &dest_len, (const Bytef*)input, static_cast<uLong>(input_size), level_);
+  if (ret != Z_OK) {
+    return 0;
+  }
+  return dest_len;
+}
+
+std::string ZlibCompress::DecompressBlock(const void* data, size_t size) {
+  // 每一帧都带有 zlib header，使用新的解压流即可
+  ResetUncompressStream_();
+  return Decompress(data, size);
 }
 }  // namespace logger
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zlib.h>
+#include <algorithm>
 #include "compress.h"
 
 namespace logger {
@@ -34,12 +35,25 @@ class ZlibCompress final : public Compression {
 
   size_t CompressedBound(size_t input_size) override;
 
+  size_t CompressBlock(const void* input, size_t input_size, void* output, size_t output_size) override;
+
+  std::string DecompressBlock(const void* data, size_t size) override;
+
+  /// @brief 暂不支持字典
+  uint32_t SetDictionary(const void* /*dict*/, size_t /*size*/) override { return 0; }
+
+  /// @brief 只影响 CompressBlock，流式压缩固定使用 Z_BEST_COMPRESSION
+  void SetLevel(int level) override { level_ = std::min(std::max(level, Z_BEST_SPEED), Z_BEST_COMPRESSION); }
+
+  int GetLevel() const override { return level_; }
+
  private:
   void ResetUncompressStream_();
 
  private:
   std::unique_ptr<z_stream, ZStreamDeflateDeleter> compress_stream_;
   std::unique_ptr<z_stream, ZStreamInflateDeleter> uncompress_stream_;
+  int level_ = Z_BEST_COMPRESSION;
 };
 
 }  // namespace logger
\ No newline at end of file
@@ -1,12 +1,19 @@
 #include "zstd_compress.h"
 
+#include <algorithm>
 #include <cstring>
 
+#include <zdict.h>
+
 namespace logger {
 
-ZstdCompress::ZstdCompress() {
+namespace {
+constexpr int kCompressionLevel = 5;
+}  // namespace
+
+ZstdCompress::ZstdCompress() : level_(kCompressionLevel) {
   cctx_ = ZSTD_createCCtx();
-  ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, 5);
+  ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level_);
 
   dctx_ = ZSTD_createDCtx();
 }
@@ -19,6 +26,9 @@ ZstdCompress::~ZstdCompress() {
   if (dctx_) {
     ZSTD_freeDCtx(dctx_);
   }
+
+  FreeCDicts_();
+  ZSTD_freeDDict(ddict_);
 }
 
 void ZstdCompress::ResetStream() {
@@ -68,25 +78,145 @@ size_t ZstdCompress::Compress(const void* data, size_t size, void* output, size_
 }
 
 std::string ZstdCompress::Decompress(const void* data, size_t size) {
-  if (!data || size == 0) {
+  std::string output;
+  if (!DecompressTo(data, size, output)) {
     return "";
   }
+  return output;
+}
+
+bool ZstdCompress::DecompressTo(const void* data, size_t size, std::string& output) {
+  if (!data || size == 0) {
+    return false;
+  }
+  // 新的一帧开始时重置解压上下文
   if (IsZSTDCompressed(data, size)) {
-    ResetStream();
+    ResetUncompressStream_();
   }
-  std::string output;
-  output.reserve(10 * 1024);
+  size_t begin = output.size();
   ZSTD_inBuffer input = {data, size, 0};
-  ZSTD_outBuffer output_buffer = {const_cast<void*>(reinterpret_cast<const void*>(output.data())), output.capacity(),
-                                  0};
-  size_t ret = ZSTD_decompressStream(dctx_, &output_buffer, &input);
+  ZSTD_outBuffer output_buffer = {nullptr, 0, 0};
+  // 单条日志通常只有几百字节，从输入大小的数倍开始，输出缓冲区写满时翻倍后继续解压
+  size_t step = std::max<size_t>(size * 4, 256);
+  do {
+    size_t old_size = output.size();
+    output.resize(old_size + step);
+    output_buffer = {output.data() + old_size, step, 0};
+    size_t ret = ZSTD_decompressStream(dctx_, &output_buffer, &input);
+    if (ZSTD_isError(ret) != 0) {
+      output.resize(begin);
+      return false;
+    }
+    output.resize(old_size + output_buffer.pos);
+    step = std::min(step * 2, ZSTD_DStreamOutSize());
+  } while (input.pos < input.size || output_buffer.pos == output_buffer.size);
+  return true;
+}
+
+size_t ZstdCompress::CompressBlock(const void* input, size_t input_size, void* output, size_t output_size) {
+  if (!input || input_size == 0) {
+    return 0;
+  }
+  // ZSTD_compress2 会重置会话，沿用 cctx_ 中设置的压缩等级
+  ZSTD_CDict* cdict = GetCDict_();
+  size_t ret = cdict ? ZSTD_compress_usingCDict(cctx_, output, output_size, input, input_size, cdict)
+                     : ZSTD_compress2(cctx_, output, output_size, input, input_size);
   if (ZSTD_isError(ret) != 0) {
+    return 0;
+  }
+  return ret;
+}
+
+std::string ZstdCompress::DecompressBlock(const void* data, size_t size) {
+  std::string output;
+  if (!DecompressBlockTo(data, size, output)) {
     return "";
   }
-  output = std::string(reinterpret_cast<char*>(output_buffer.dst), output_buffer.pos);
   return output;
 }
 
+bool ZstdCompress::DecompressBlockTo(const void* data, size_t size, std::string& output) {
+  if (!data || size == 0) {
+    return false;
+  }
+  unsigned long long content_size = ZSTD_getFrameContentSize(data, size);
+  if (content_size == ZSTD_CONTENTSIZE_ERROR || content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+    return false;
+  }
+  size_t begin = output.size();
+  output.resize(begin + content_size);
+  // 帧头中记录了字典 id，没有使用字典的帧不受 ddict_ 影响
+  size_t ret = ZSTD_getDictID_fromFrame(data, size) != 0 && ddict_
+                   ? ZSTD_decompress_usingDDict(dctx_, output.data() + begin, content_size, data, size, ddict_)
+                   : ZSTD_decompressDCtx(dctx_, output.data() + begin, content_size, data, size);
+  if (ZSTD_isError(ret) != 0) {
+    output.resize(begin);
+    return false;
+  }
+  output.resize(begin + ret);
+  return true;
+}
+
+uint32_t ZstdCompress::SetDictionary(const void* dict, size_t size) {
+  ZSTD_CDict* cdict = ZSTD_createCDict(dict, size, level_);
+  ZSTD_DDict* ddict = ZSTD_createDDict(dict, size);
+  uint32_t dict_id = static_cast<uint32_t>(ZSTD_getDictID_fromDict(dict, size));
+  if (!cdict || !ddict || dict_id == 0) {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+    return 0;
+  }
+  FreeCDicts_();
+  ZSTD_freeDDict(ddict_);
+  dict_.assign(static_cast<const char*>(dict), size);
+  cdicts_[level_] = cdict;
+  ddict_ = ddict;
+  return dict_id;
+}
+
+void ZstdCompress::SetLevel(int level) {
+  level_ = std::min(std::max(level, ZSTD_minCLevel()), ZSTD_maxCLevel());
+  ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level_);
+}
+
+ZSTD_CDict* ZstdCompress::GetCDict_() {
+  if (dict_.empty()) {
+    return nullptr;
+  }
+  auto it = cdicts_.find(level_);
+  if (it != cdicts_.end()) {
+    return it->second;
+  }
+  ZSTD_CDict* cdict = ZSTD_createCDict(dict_.data(), dict_.size(), level_);
+  cdicts_[level_] = cdict;
+  return cdict;
+}
+
+void ZstdCompress::FreeCDicts_() {
+  for (auto& [level, cdict] : cdicts_) {
+    ZSTD_freeCDict(cdict);
+  }
+  cdicts_.clear();
+}
+
+std::string ZstdCompress::TrainDictionary(const std::vector<std::string>& samples, size_t capacity) {
+  std::string buffer;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    buffer.append(sample);
+    sizes.push_back(sample.size());
+  }
+  std::string dict(capacity, '\0');
+  size_t ret = ZDICT_trainFromBuffer(dict.data(), dict.size(), buffer.data(), sizes.data(),
+                                     static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(ret) != 0) {
+    return "";
+  }
+  dict.resize(ret);
+  return dict;
+}
+
 size_t ZstdCompress::CompressedBound(size_t input_size) {
   return ZSTD_compressBound(input_size);
 }
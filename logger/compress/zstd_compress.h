@@ -4,6 +4,9 @@
 
 #include <zstd.h>
 
+#include <unordered_map>
+#include <vector>
+
 namespace logger {
 
 class ZstdCompress final : public Compression {
@@ -16,16 +19,49 @@ class ZstdCompress final : public Compression {
 
   std::string Decompress(const void* data, size_t size) override;
 
+  /// @brief 输出缓冲区按输入大小逐步扩大，不再每次预留 ZSTD_DStreamOutSize()
+  bool DecompressTo(const void* data, size_t size, std::string& output) override;
+
   void ResetStream() override;
 
   size_t CompressedBound(size_t input_size) override;
 
+  size_t CompressBlock(const void* input, size_t input_size, void* output, size_t output_size) override;
+
+  std::string DecompressBlock(const void* data, size_t size) override;
+
+  bool DecompressBlockTo(const void* data, size_t size, std::string& output) override;
+
+  /// @brief 预先解析字典，之后每个块直接引用，不再重复加载
+  uint32_t SetDictionary(const void* dict, size_t size) override;
+
+  /// @brief 支持负数的快速等级，使用字典时每个等级首次使用时解析一次字典
+  void SetLevel(int level) override;
+
+  int GetLevel() const override { return level_; }
+
+  /// @brief 使用日志样本训练字典
+  /// @param samples 每个元素为一条样本，如序列化后的 EffectiveMsg
+  /// @param capacity 字典最大字节数
+  /// @return 字典内容，样本不足等原因失败时返回空字符串
+  static std::string TrainDictionary(const std::vector<std::string>& samples, size_t capacity);
+
  private:
   void ResetUncompressStream_();
 
+  /// @brief 获取当前等级对应的 CDict，CDict 的压缩等级在创建时确定
+  /// @return
+  ZSTD_CDict* GetCDict_();
+
+  void FreeCDicts_();
+
  private:
   ZSTD_CCtx* cctx_;
   ZSTD_DCtx* dctx_;
+  int level_;
+  std::string dict_;
+  std::unordered_map<int, ZSTD_CDict*> cdicts_;  // 压缩等级 -> CDict
+  ZSTD_DDict* ddict_ = nullptr;
 };
 
 }  // namespace logger
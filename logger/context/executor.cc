@@ -96,6 +96,7 @@ void Executor::ExecutorTimer::PostDelayedTask(Task task, const std::chrono::micr
   }
 }
 void Executor::ExecutorTimer::CancelRepeatedTask(RepeatedTaskId task_id) {
+  std::lock_guard<std::mutex> lock(repeated_mutex_);
   repeated_task_id_set.erase(task_id);
 }
 
@@ -108,7 +109,10 @@ RepeatedTaskId Executor::ExecutorTimer::PostRepeatedTask(Task task,
                                                          const std::chrono::microseconds& delaytime,
                                                          uint64_t repeat_num) {
   RepeatedTaskId id = repeated_task_id_++;
-  repeated_task_id_set.insert(id);
+  {
+    std::lock_guard<std::mutex> lock(repeated_mutex_);
+    repeated_task_id_set.insert(id);
+  }
   PostRepeatedTask_(std::move(task), delaytime, id, repeat_num);
   return id;
 }
@@ -118,16 +122,20 @@ void Executor::ExecutorTimer::PostRepeatedTask_(Task task,
                                                 const std::chrono::microseconds& delaytime,
                                                 RepeatedTaskId id,
                                                 uint64_t repeat_num) {
-  // 若 id 不存在表示已经移除该重复任务，则不需要进行执行
-  if (repeated_task_id_set.find(id) == repeated_task_id_set.end()) {
-    return;
-  }
-  // 若执行完毕指定次数则不需进行执行
-  if (repeat_num == 0) {
-    return;
-  }
+  {
+    // 检查后到执行完之前持有锁，CancelRepeatedTask 返回后不会再有该任务被投递
+    std::lock_guard<std::mutex> lock(repeated_mutex_);
+    // 若 id 不存在表示已经移除该重复任务，则不需要进行执行
+    if (repeated_task_id_set.find(id) == repeated_task_id_set.end()) {
+      return;
+    }
+    // 若执行完毕指定次数则不需进行执行
+    if (repeat_num == 0) {
+      return;
+    }
 
-  task();
+    task();
+  }
 
   Task func =
       std::bind(&Executor::ExecutorTimer::PostRepeatedTask_, this, std::move(task), delaytime, id, repeat_num - 1);
@@ -40,6 +40,8 @@ class Executor {
     void PostDelayedTask(Task task, const std::chrono::microseconds& delaytime);
     RepeatedTaskId PostRepeatedTask(Task task, const std::chrono::microseconds& delaytime, uint64_t repeat_num);
 
+    /// @brief 取消重复任务，返回后该任务不会再被投递，已投递到 runner 的任务仍会执行
+    /// @param task_id
     void CancelRepeatedTask(RepeatedTaskId task_id);
 
    private:
@@ -65,6 +67,8 @@ class Executor {
     std::atomic<bool> running_;
 
     std::atomic<RepeatedTaskId> repeated_task_id_;
+    // 保护 repeated_task_id_set，检查与执行任务时一直持有，取消与正在进行的投递互斥
+    std::mutex repeated_mutex_;
     std::unordered_set<RepeatedTaskId> repeated_task_id_set;
   };
 
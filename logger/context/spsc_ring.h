@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace logger {
+/// @brief 单生产者单消费者的无锁字节环形缓冲区
+/// 每条记录以 uint32_t 长度作为前缀并按 8 字节对齐，记录不会跨越缓冲区尾部：
+/// 尾部剩余空间不足时写入回绕标记，从缓冲区起始位置继续写入
+class SpscRing {
+ public:
+  /// @brief 容量会向上取整为 2 的幂
+  /// @param capacity
+  explicit SpscRing(size_t capacity) : capacity_(RoundUpPow2_(capacity)), mask_(capacity_ - 1) {
+    buffer_ = std::make_unique<char[]>(capacity_);
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  /// @brief 记录是否可能放入缓冲区(不考虑当前占用)
+  /// @param size
+  /// @return
+  bool Fits(size_t size) const noexcept { return RecordSize_(size) <= capacity_; }
+
+  /// @brief 生产者调用，空间不足时返回 false
+  /// @param data
+  /// @param size
+  /// @return
+  bool TryPush(const void* data, size_t size) { return TryPush(data, size, nullptr, 0); }
+
+  /// @brief 生产者调用，将 head 与 body 拼接为一条记录写入，避免调用方额外拷贝
+  /// @param head
+  /// @param head_size
+  /// @param body
+  /// @param body_size
+  /// @return
+  bool TryPush(const void* head, size_t head_size, const void* body, size_t body_size) {
+    size_t size = head_size + body_size;
+    size_t need = RecordSize_(size);
+    if (need > capacity_) {
+      return false;
+    }
+    uint64_t head_pos = head_.load(std::memory_order_relaxed);
+    size_t offset = head_pos & mask_;
+    size_t to_end = capacity_ - offset;
+    // 尾部空间不够则需要额外占用 to_end 字节用于回绕
+    size_t total = to_end < need ? to_end + need : need;
+    if (head_pos + total - cached_tail_ > capacity_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head_pos + total - cached_tail_ > capacity_) {
+        return false;
+      }
+    }
+    if (to_end < need) {
+      uint32_t marker = kWrapMarker;
+      memcpy(buffer_.get() + offset, &marker, sizeof(marker));
+      head_pos += to_end;
+      offset = 0;
+    }
+    uint32_t len = static_cast<uint32_t>(size);
+    char* dst = buffer_.get() + offset;
+    memcpy(dst, &len, sizeof(len));
+    if (head_size > 0) {
+      memcpy(dst + sizeof(len), head, head_size);
+    }
+    if (body_size > 0) {
+      memcpy(dst + sizeof(len) + head_size, body, body_size);
+    }
+    head_.store(head_pos + need, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief 消费者调用，依次将当前所有记录交给 func(const char* data, size_t size) 处理
+  /// @tparam F
+  /// @param func
+  /// @return 处理的记录条数
+  template <typename F>
+  size_t Drain(F&& func) {
+    uint64_t tail_pos = tail_.load(std::memory_order_relaxed);
+    uint64_t head_pos = head_.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (tail_pos != head_pos) {
+      size_t offset = tail_pos & mask_;
+      uint32_t len = 0;
+      memcpy(&len, buffer_.get() + offset, sizeof(len));
+      if (len == kWrapMarker) {
+        tail_pos += capacity_ - offset;
+        continue;
+      }
+      func(static_cast<const char*>(buffer_.get() + offset + sizeof(len)), static_cast<size_t>(len));
+      tail_pos += RecordSize_(len);
+      // 每处理一条即释放空间，避免批量较大时生产者长时间等待
+      tail_.store(tail_pos, std::memory_order_release);
+      ++count;
+    }
+    return count;
+  }
+
+  /// @brief 已占用的字节数(含长度前缀与对齐)，其他线程读取时只是近似值
+  /// @return
+  size_t Size() const noexcept {
+    return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+  }
+
+  size_t Capacity() const noexcept { return capacity_; }
+
+  bool Empty() const noexcept {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr uint32_t kWrapMarker = 0xffffffff;
+  static constexpr size_t kAlign = 8;
+
+  static size_t RecordSize_(size_t size) noexcept { return (sizeof(uint32_t) + size + kAlign - 1) & ~(kAlign - 1); }
+
+  static size_t RoundUpPow2_(size_t size) noexcept {
+    size_t capacity = 64;
+    while (capacity < size) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+
+ private:
+  // 生产者与消费者各自写的位置放在不同 cache line，避免伪共享
+  alignas(64) std::atomic<uint64_t> head_{0};
+  uint64_t cached_tail_{0};  // 生产者缓存的 tail，减少跨核读取
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  alignas(64) std::unique_ptr<char[]> buffer_;
+  size_t capacity_;
+  size_t mask_;
+};
+}  // namespace logger
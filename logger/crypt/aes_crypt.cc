@@ -1,5 +1,7 @@
 #include "crypt/aes_crypt.h"
 
+#include <cstring>
+
 #include "cryptopp/aes.h"
 #include "cryptopp/base64.h"
 #include "cryptopp/cryptlib.h"
@@ -41,16 +43,15 @@ void Encrypt(const void* input, size_t input_size, std::string& output, const st
   stf_encryptor.MessageEnd();
 }
 
-static std::string Decrypt(const void* data, size_t size, const std::string& key, const std::string& iv) {
-  std::string decryptedtext;
+static void Decrypt(const void* data, size_t size, std::string& output, const std::string& key, const std::string& iv) {
   CryptoPP::AES::Decryption aes_decryption(reinterpret_cast<const byte*>(key.data()), key.size());
   CryptoPP::CBC_Mode_ExternalCipher::Decryption cbc_decryption(aes_decryption,
                                                                reinterpret_cast<const byte*>(iv.data()));
 
-  CryptoPP::StreamTransformationFilter stf_decryptor(cbc_decryption, new CryptoPP::StringSink(decryptedtext));
+  // StringSink 追加到 output 末尾
+  CryptoPP::StreamTransformationFilter stf_decryptor(cbc_decryption, new CryptoPP::StringSink(output));
   stf_decryptor.Put(reinterpret_cast<const byte*>(data), size);
   stf_decryptor.MessageEnd();
-  return decryptedtext;
 }
 }  // namespace detail
 
@@ -64,7 +65,13 @@ void AESCrypt::Encrypt(const void* input, size_t input_size, std::string& output
 }
 
 std::string AESCrypt::Decrypt(const void* data, size_t size) {
-  return detail::Decrypt(data, size, key_, iv_);
+  std::string output;
+  detail::Decrypt(data, size, output, key_, iv_);
+  return output;
+}
+
+void AESCrypt::DecryptTo(const void* data, size_t size, std::string& output) {
+  detail::Decrypt(data, size, output, key_, iv_);
 }
 
 std::string AESCrypt::GenerateKey() {
@@ -75,5 +82,60 @@ std::string AESCrypt::GenerateIV() {
   return detail::GenerateIV();
 }
 
+struct AESCtrCrypt::Cipher {
+  // cryptopp 在支持 AES-NI 的 CPU 上自动使用硬件指令
+  CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption ctr;
+};
+
+AESCtrCrypt::AESCtrCrypt(const std::string& key) : cipher_(std::make_unique<Cipher>()) {
+  CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE] = {0};
+  cipher_->ctr.SetKeyWithIV(reinterpret_cast<const CryptoPP::byte*>(key.data()), key.size(), iv, sizeof(iv));
+}
+
+AESCtrCrypt::~AESCtrCrypt() = default;
+
+std::string AESCtrCrypt::GenerateNonce() {
+  CryptoPP::AutoSeededRandomPool rnd;
+  std::string nonce(kNonceSize, '\0');
+  rnd.GenerateBlock(reinterpret_cast<CryptoPP::byte*>(nonce.data()), nonce.size());
+  return nonce;
+}
+
+void AESCtrCrypt::Reset(const char* nonce) {
+  memcpy(nonce_, nonce, kNonceSize);
+  seq_ = 0;
+}
+
+void AESCtrCrypt::Process_(const void* input, size_t size, void* output) {
+  CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE] = {0};
+  memcpy(iv, nonce_, kNonceSize);
+  iv[8] = static_cast<CryptoPP::byte>(seq_ >> 24);
+  iv[9] = static_cast<CryptoPP::byte>(seq_ >> 16);
+  iv[10] = static_cast<CryptoPP::byte>(seq_ >> 8);
+  iv[11] = static_cast<CryptoPP::byte>(seq_);
+  ++seq_;
+  // 只更新计数器，不重新扩展密钥
+  cipher_->ctr.Resynchronize(iv, sizeof(iv));
+  cipher_->ctr.ProcessData(static_cast<CryptoPP::byte*>(output), static_cast<const CryptoPP::byte*>(input), size);
+}
+
+void AESCtrCrypt::Encrypt(const void* input, size_t input_size, std::string& output) {
+  size_t offset = output.size();
+  output.resize(offset + input_size);
+  Process_(input, input_size, output.data() + offset);
+}
+
+std::string AESCtrCrypt::Decrypt(const void* data, size_t size) {
+  std::string output(size, '\0');
+  Process_(data, size, output.data());
+  return output;
+}
+
+void AESCtrCrypt::DecryptTo(const void* data, size_t size, std::string& output) {
+  size_t offset = output.size();
+  output.resize(offset + size);
+  Process_(data, size, output.data() + offset);
+}
+
 }  // namespace crypt
 }  // namespace logger
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "crypt.h"
 
 namespace logger {
@@ -18,10 +20,54 @@ class AESCrypt final : public Crypt {
 
   std::string Decrypt(const void* data, size_t size) override;
 
+  void DecryptTo(const void* data, size_t size, std::string& output) override;
+
  private:
   std::string key_;
   std::string iv_;
 };
 
+/// @brief AES-CTR 加密：密钥只在构造时扩展一次，密文与明文等长，不需要填充
+/// 每个 chunk 使用随机的 nonce，chunk 中第 seq 次 Encrypt/Decrypt 的初始计数器为
+/// nonce(8 字节) || seq(4 字节，大端) || 0(4 字节)，单次调用的数据不能超过 64GB
+class AESCtrCrypt final : public Crypt {
+ public:
+  static constexpr size_t kNonceSize = 8;
+
+  explicit AESCtrCrypt(const std::string& key);
+  ~AESCtrCrypt() override;
+
+  /// @brief 生成随机 nonce
+  /// @return kNonceSize 字节的二进制数据
+  static std::string GenerateNonce();
+
+  /// @brief 开始新的 chunk，之后的第一次调用 seq 为 0
+  /// @param nonce kNonceSize 字节
+  void Reset(const char* nonce);
+
+  /// @brief 指定下一次调用使用的 seq，用于跳过部分块
+  /// @param seq
+  void Seek(uint32_t seq) { seq_ = seq; }
+
+  /// @brief 加密后追加到 output 末尾，seq 加 1
+  void Encrypt(const void* input, size_t input_size, std::string& output) override;
+
+  /// @brief seq 加 1
+  std::string Decrypt(const void* data, size_t size) override;
+
+  /// @brief 明文与密文等长，output 容量足够时不分配内存，seq 加 1
+  void DecryptTo(const void* data, size_t size, std::string& output) override;
+
+ private:
+  /// @brief 以当前 seq 设置计数器并处理数据
+  void Process_(const void* input, size_t size, void* output);
+
+ private:
+  struct Cipher;
+  std::unique_ptr<Cipher> cipher_;  // 已扩展密钥的 CTR 对象，隐藏 cryptopp 头文件
+  char nonce_[kNonceSize] = {0};
+  uint32_t seq_ = 0;
+};
+
 }  // namespace crypt
 }  // namespace logger
@@ -23,6 +23,12 @@ class Crypt {
   virtual void Encrypt(const void* input, size_t input_size, std::string& output) = 0;
 
   virtual std::string Decrypt(const void* data, size_t size) = 0;
+
+  /// @brief 解密后追加到 output 末尾，output 已有的容量可以复用
+  /// @param data
+  /// @param size
+  /// @param output
+  virtual void DecryptTo(const void* data, size_t size, std::string& output) { output.append(Decrypt(data, size)); }
 };
 }  // namespace crypt
 
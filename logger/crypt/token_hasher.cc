@@ -0,0 +1,42 @@
+#include "token_hasher.h"
+
+#include <cstring>
+
+#include "aes_crypt.h"
+#include "cryptopp/hmac.h"
+#include "cryptopp/sha.h"
+#include "cryptopp/siphash.h"
+
+namespace logger {
+namespace crypt {
+static constexpr char kBloomLabel[] = "tlog-bloom";
+
+struct TokenHasher::Mac {
+  CryptoPP::HMAC<CryptoPP::SHA256> hmac;
+  CryptoPP::SipHash<2, 4, false> siphash;
+};
+
+TokenHasher::TokenHasher(const std::string& shared_secret) : mac_(std::make_unique<Mac>()) {
+  mac_->hmac.SetKey(reinterpret_cast<const CryptoPP::byte*>(shared_secret.data()), shared_secret.size());
+}
+
+TokenHasher::~TokenHasher() = default;
+
+void TokenHasher::Reset(const char* nonce) {
+  CryptoPP::byte digest[CryptoPP::SHA256::DIGESTSIZE];
+  mac_->hmac.Update(reinterpret_cast<const CryptoPP::byte*>(kBloomLabel), sizeof(kBloomLabel) - 1);
+  mac_->hmac.Update(reinterpret_cast<const CryptoPP::byte*>(nonce), AESCtrCrypt::kNonceSize);
+  mac_->hmac.Final(digest);
+  mac_->siphash.SetKey(digest, 16);
+}
+
+uint64_t TokenHasher::Hash(const void* data, size_t size) {
+  CryptoPP::byte digest[8];
+  mac_->siphash.CalculateDigest(digest, static_cast<const CryptoPP::byte*>(data), size);
+  uint64_t hash = 0;
+  memcpy(&hash, digest, sizeof(hash));
+  return hash;
+}
+
+}  // namespace crypt
+}  // namespace logger
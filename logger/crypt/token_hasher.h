@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace logger {
+namespace crypt {
+
+/// @brief 计算日志内容中词的带密钥哈希，用于 chunk 的 Bloom 过滤器
+/// 每个 chunk 的密钥为 HMAC-SHA256(共享密钥, "tlog-bloom" || nonce) 的前 16 字节，以 SipHash-2-4 计算哈希
+/// 没有共享密钥无法由过滤器推测其中的词，同一个词在不同 chunk 中的位置也互不相关
+class TokenHasher {
+ public:
+  explicit TokenHasher(const std::string& shared_secret);
+  ~TokenHasher();
+
+  /// @brief 切换到一个 chunk 的密钥
+  /// @param nonce AESCtrCrypt::kNonceSize 字节
+  void Reset(const char* nonce);
+
+  uint64_t Hash(const void* data, size_t size);
+
+ private:
+  struct Mac;
+  std::unique_ptr<Mac> mac_;  // 隐藏 cryptopp 头文件
+};
+
+}  // namespace crypt
+}  // namespace logger
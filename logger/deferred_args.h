@@ -0,0 +1,106 @@
+#pragma once
+
+#include <fmt/core.h>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "log_msg.h"
+
+namespace logger {
+namespace detail {
+template <typename T>
+constexpr bool kIsStringArg = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+                              std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+// 只有值语义的参数可以按字节拷贝；视图、指针(void* 除外，按地址格式化)以及含指针的结构体
+// 引用的内容在后台格式化时可能已失效，保持立即格式化
+template <typename T>
+constexpr bool kIsValueArg = std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, void*> ||
+                             std::is_same_v<T, const void*>;
+
+/// @brief 单个参数的序列化方式，默认不支持延迟格式化
+template <typename T, typename = void>
+struct ArgCodec {
+  static constexpr bool kDeferrable = false;
+};
+
+/// @brief 字符串类参数：拷贝一份内容(长度 + 字节)，格式化时以 StringView 还原
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<kIsStringArg<T>>> {
+  static constexpr bool kDeferrable = true;
+  using Value = StringView;
+
+  template <typename Buffer>
+  static void Encode(Buffer& buf, const T& arg) {
+    StringView str;
+    if constexpr (std::is_pointer_v<T>) {
+      // 空指针按空字符串记录，避免 strlen 访问空指针
+      if (arg != nullptr) {
+        str = arg;
+      }
+    } else {
+      str = arg;
+    }
+    uint32_t size = static_cast<uint32_t>(str.size());
+    buf.append(reinterpret_cast<const char*>(&size), reinterpret_cast<const char*>(&size) + sizeof(size));
+    buf.append(str.data(), str.data() + str.size());
+  }
+
+  static Value Decode(const char*& data) {
+    uint32_t size = 0;
+    memcpy(&size, data, sizeof(size));
+    StringView str(data + sizeof(size), size);
+    data += sizeof(size) + size;
+    return str;
+  }
+};
+
+/// @brief 整数、浮点、枚举及 void* 参数：直接按字节拷贝
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<kIsValueArg<T>>> {
+  static constexpr bool kDeferrable = true;
+  using Value = T;
+
+  template <typename Buffer>
+  static void Encode(Buffer& buf, const T& arg) {
+    buf.append(reinterpret_cast<const char*>(&arg), reinterpret_cast<const char*>(&arg) + sizeof(T));
+  }
+
+  static Value Decode(const char*& data) {
+    Value value;
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+  }
+};
+
+/// @brief 一次日志调用的格式字符串与全部参数：调用线程上 Encode，后台线程上 Format
+/// fmt 可能来自 fmt::runtime 包装的临时字符串，因此与参数一样拷贝，位于参数之前
+/// @tparam ...Args
+template <typename... Args>
+struct DeferredCodec {
+  static constexpr bool kDeferrable = (ArgCodec<std::decay_t<Args>>::kDeferrable && ...);
+
+  template <typename Buffer>
+  static void Encode(Buffer& buf, StringView fmt, const Args&... args) {
+    ArgCodec<StringView>::Encode(buf, fmt);
+    (ArgCodec<std::decay_t<Args>>::Encode(buf, args), ...);
+  }
+
+  static void Format(const char* data, std::string* dest) {
+    StringView fmt = ArgCodec<StringView>::Decode(data);
+    // 花括号初始化保证参数按从左到右的顺序解码
+    std::tuple<typename ArgCodec<std::decay_t<Args>>::Value...> values{ArgCodec<std::decay_t<Args>>::Decode(data)...};
+    std::apply(
+        [&](auto&... args) {
+          fmt::vformat_to(std::back_inserter(*dest), fmt::string_view(fmt.data(), fmt.size()),
+                          fmt::make_format_args(args...));
+        },
+        values);
+  }
+};
+}  // namespace detail
+}  // namespace logger
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include "aes_crypt.h"
@@ -12,4 +13,28 @@ int main() {
 
   std::string destr = aes.Decrypt(str.c_str(), str.size());
   std::cout << destr << std::endl;
-}
\ No newline at end of file
+
+  // AES-CTR：同一 nonce 下第 n 次加密对应第 n 次解密，密文与明文等长
+  logger::crypt::AESCtrCrypt ctr(std::string(32, 'k'));
+  std::string nonce = logger::crypt::AESCtrCrypt::GenerateNonce();
+  ctr.Reset(nonce.data());
+  std::string first;
+  std::string second;
+  ctr.Encrypt(text, input_size, first);
+  ctr.Encrypt(text, input_size, second);
+  ctr.Reset(nonce.data());
+  std::cout << ctr.Decrypt(first.data(), first.size()) << " " << ctr.Decrypt(second.data(), second.size())
+            << " same ciphertext: " << (first == second) << std::endl;
+
+  // 按字节统计加密开销
+  std::string block(64 * 1024, 'x');
+  std::string output;
+  const int kCount = 2000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kCount; ++i) {
+    output.clear();
+    ctr.Encrypt(block.data(), block.size(), output);
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "AES-CTR: " << static_cast<double>(ns) / (block.size() * kCount) << " ns/byte" << std::endl;
+}
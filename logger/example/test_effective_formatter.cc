@@ -0,0 +1,70 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "effective_formatter.h"
+#include "effective_msg.pb.h"
+#include "sys_util.h"
+#include "timer_counter.h"
+
+using namespace logger;
+
+// 原先基于 EffectiveMsg 的实现，作为对照
+void ProtobufFormat(const LogMsg& msg, std::string* dest) {
+  EffectiveMsg eff_msg;
+  eff_msg.set_level(static_cast<int32_t>(msg.level));
+  eff_msg.set_timestamp(msg.WallMs());
+  eff_msg.set_pid(GetProcessId());
+  eff_msg.set_tid(msg.thread_id);
+  eff_msg.set_thread_name_id(msg.thread_name_id);
+  if (msg.location.site_id != 0) {
+    eff_msg.set_site_id(msg.location.site_id);
+  } else {
+    eff_msg.set_line(msg.location.line);
+    eff_msg.set_file_name(msg.location.file_name.data(), msg.location.file_name.size());
+    eff_msg.set_func_name(msg.location.func_name.data(), msg.location.func_name.size());
+  }
+  eff_msg.set_log_info(msg.message.data(), msg.message.size());
+  size_t len = eff_msg.ByteSizeLong();
+  dest->resize(len);
+  eff_msg.SerializeToArray(dest->data(), len);
+}
+
+int main() {
+  std::string long_message(1000, 'x');
+  std::vector<LogMsg> msgs;
+  msgs.emplace_back(SourceLocation{__FILE__, __LINE__, __func__}, LogLevel::kInfo, "hello effective formatter");
+  msgs.emplace_back(SourceLocation{__FILE__, -1, __func__}, LogLevel::kTrace, "");
+  msgs.emplace_back(LogLevel::kError, long_message);
+  SourceLocation site{__FILE__, __LINE__, __func__};
+  site.site_id = 300;
+  msgs.emplace_back(site, LogLevel::kWarn, "registered call site");
+  msgs.back().thread_name_id = 5;
+
+  // 两种实现的输出必须逐字节一致，保证解码工具可以正常解析
+  EffectiveFormatter formatter;
+  std::string expected;
+  std::string actual;
+  for (const auto& msg : msgs) {
+    ProtobufFormat(msg, &expected);
+    formatter.Format(msg, &actual);
+    assert(expected == actual);
+  }
+
+  const int kCount = 1000000;
+  {
+    TIMER_COUNT("protobuf EffectiveMsg");
+    for (int i = 0; i < kCount; ++i) {
+      ProtobufFormat(msgs[0], &expected);
+    }
+  }
+  {
+    TIMER_COUNT("EffectiveFormatter");
+    for (int i = 0; i < kCount; ++i) {
+      formatter.Format(msgs[0], &actual);
+    }
+  }
+  std::cout << "EffectiveFormatter 测试通过" << std::endl;
+  return 0;
+}
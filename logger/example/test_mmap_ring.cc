@@ -0,0 +1,45 @@
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "mmap_ring.h"
+
+using namespace logger;
+
+int main() {
+  std::filesystem::path path = "test_mmap_ring/ring";
+  std::filesystem::remove_all(path.parent_path());
+  {
+    MmapRing ring(path, 4096, true);
+    assert(ring.IsValid());
+    size_t capacity = ring.Capacity();
+    std::string chunk(capacity / 3, 'a');
+    // 反复写入、消费，使数据跨越数据区末尾
+    for (int i = 0; i < 10; ++i) {
+      chunk.assign(chunk.size(), static_cast<char>('a' + i));
+      assert(ring.Push(chunk.data(), chunk.size()));
+      StringView first;
+      StringView second;
+      ring.Peek(ring.Tail(), chunk.size(), &first, &second);
+      assert(std::string(first) + std::string(second) == chunk);
+      ring.Consume(chunk.size());
+    }
+    assert(ring.Empty());
+    // 空间不足时拒绝写入，不会扩容
+    std::string large(capacity + 1, 'x');
+    assert(!ring.Push(large.data(), large.size()));
+    assert(ring.Push(chunk.data(), chunk.size()));
+  }
+  {
+    // 未消费的数据在重新打开后仍然存在
+    MmapRing ring(path, 4096, false);
+    assert(ring.Size() == ring.Capacity() / 3);
+    std::string data(ring.Size(), '\0');
+    ring.Read(ring.Tail(), data.data(), data.size());
+    assert(data == std::string(data.size(), 'j'));
+  }
+  std::filesystem::remove_all(path.parent_path());
+  std::cout << "MmapRing 测试通过" << std::endl;
+  return 0;
+}
@@ -0,0 +1,37 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "spsc_ring.h"
+
+using namespace logger;
+
+int main() {
+  SpscRing ring(1024);
+  const int kCount = 100000;
+
+  // 生产者写入长度不一的记录，消费者按顺序校验内容
+  std::thread producer([&ring]() {
+    for (int i = 0; i < kCount; ++i) {
+      std::string record = std::to_string(i) + std::string(i % 37, 'x');
+      while (!ring.TryPush(record.data(), record.size())) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  while (expected < kCount) {
+    ring.Drain([&expected](const char* data, size_t size) {
+      std::string record = std::to_string(expected) + std::string(expected % 37, 'x');
+      assert(record == std::string(data, size));
+      ++expected;
+    });
+  }
+  producer.join();
+  assert(ring.Empty());
+  assert(!ring.Fits(2048));
+  std::cout << "SpscRing 测试通过" << std::endl;
+  return 0;
+}
@@ -1,32 +1,155 @@
 #include "default_formatter.h"
 
+#include <fmt/format.h>
+
+#include "thread_name.h"
+
 namespace logger {
+namespace {
+// 即 Trace Debug Info Warn Error Fatal 六个等级，其对应的宏编号为 0~5
+constexpr char kLogLevelStr[] = "TDIWEF";
+
+/// @brief 每个线程缓存最近一秒的日期字符串，同一秒内的日志不再调用 localtime/strftime
+struct DateCache {
+  int64_t seconds = -1;
+  char buf[32] = {0};
+  size_t size = 0;
+};
+
+void AppendDate(int64_t seconds, std::string* dest) {
+  static thread_local DateCache cache;
+  if (cache.seconds != seconds) {
+    std::time_t now = static_cast<std::time_t>(seconds);
+    std::tm tm;
+    LocalTime(&tm, &now);
+    cache.size = std::strftime(cache.buf, sizeof(cache.buf), "%Y-%m-%d %H:%M:%S", &tm);
+    cache.seconds = seconds;
+  }
+  dest->append(cache.buf, cache.size);
+}
+
+template <typename Int>
+void AppendInt(Int value, std::string* dest) {
+  fmt::format_int str(value);
+  dest->append(str.data(), str.size());
+}
+}  // namespace
+
+DefaultFormatter::DefaultFormatter() : DefaultFormatter(kDefaultPattern) {}
+
+DefaultFormatter::DefaultFormatter(const std::string& pattern) {
+  SetPattern(pattern);
+}
+
+void DefaultFormatter::AddLiteral_(char ch) {
+  if (items_.empty() || items_.back().op != Op::kLiteral) {
+    items_.push_back(Item{Op::kLiteral, std::string()});
+  }
+  items_.back().literal.push_back(ch);
+}
+
+void DefaultFormatter::SetPattern(const std::string& pattern) {
+  items_.clear();
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%') {
+      AddLiteral_(pattern[i]);
+      continue;
+    }
+    if (++i == pattern.size()) {
+      AddLiteral_('%');
+      break;
+    }
+    switch (pattern[i]) {
+      case 'l':
+        items_.push_back(Item{Op::kLevel, std::string()});
+        break;
+      case 'D':
+        items_.push_back(Item{Op::kDate, std::string()});
+        break;
+      case 'S':
+        items_.push_back(Item{Op::kSeconds, std::string()});
+        break;
+      case 'M':
+        items_.push_back(Item{Op::kMilliseconds, std::string()});
+        break;
+      case 'p':
+        items_.push_back(Item{Op::kProcessId, std::string()});
+        break;
+      case 't':
+        items_.push_back(Item{Op::kThreadId, std::string()});
+        break;
+      case 'n':
+        items_.push_back(Item{Op::kThreadName, std::string()});
+        break;
+      case 'F':
+        items_.push_back(Item{Op::kFileName, std::string()});
+        break;
+      case 'f':
+        items_.push_back(Item{Op::kFuncName, std::string()});
+        break;
+      case '#':
+        items_.push_back(Item{Op::kLine, std::string()});
+        break;
+      case 'v':
+        items_.push_back(Item{Op::kMessage, std::string()});
+        break;
+      case '%':
+        AddLiteral_('%');
+        break;
+      default:
+        // 未知标记原样输出
+        AddLiteral_('%');
+        AddLiteral_(pattern[i]);
+        break;
+    }
+  }
+}
 
-// [2025-04-27 12:00:00.000] [INFO] [file.cc:123] [pid:tid] message
 void DefaultFormatter::Format(const LogMsg& msg, std::string* dest) {
-  // 即 Trace Debug Info Warn Error Fatal 六个等级，其对应的宏编号为 0~5
-  const std::string kLogLevelStr = "TDIWEF";
-  std::time_t now = std::time(nullptr);
-  std::tm tm;
-
-  LocalTime(&tm, &now);
-
-  char time_buf[32] = {0};
-
-  std::strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm);
-  dest->append("[", 1);
-  dest->append(time_buf, strlen(time_buf));
-  dest->append("] [", 3);
-  dest->append(1, kLogLevelStr[static_cast<int>(msg.level)]);
-  dest->append("] [", 3);
-  dest->append(msg.location.file_name.data(), msg.location.file_name.size());
-  dest->append(":", 1);
-  dest->append(std::to_string(msg.location.line));
-  dest->append("] [", 3);
-  dest->append(std::to_string(GetProcessId()));
-  dest->append(":", 1);
-  dest->append(std::to_string(GetThreadId()));
-  dest->append("] ", 2);
-  dest->append(msg.message.data(), msg.message.size());
+  int64_t wall_ms = msg.WallMs();
+  for (const auto& item : items_) {
+    switch (item.op) {
+      case Op::kLiteral:
+        dest->append(item.literal);
+        break;
+      case Op::kLevel: {
+        auto index = static_cast<size_t>(msg.level);
+        dest->push_back(index < sizeof(kLogLevelStr) - 1 ? kLogLevelStr[index] : 'U');
+        break;
+      }
+      case Op::kDate:
+        AppendDate(wall_ms / 1000, dest);
+        break;
+      case Op::kSeconds:
+        AppendInt(wall_ms / 1000, dest);
+        break;
+      case Op::kMilliseconds:
+        AppendInt(wall_ms, dest);
+        break;
+      case Op::kProcessId:
+        AppendInt(GetProcessId(), dest);
+        break;
+      case Op::kThreadId:
+        AppendInt(msg.thread_id, dest);
+        break;
+      case Op::kThreadName: {
+        StringView name = GetThreadName(msg.thread_name_id);
+        dest->append(name.data(), name.size());
+        break;
+      }
+      case Op::kFileName:
+        dest->append(msg.location.file_name.data(), msg.location.file_name.size());
+        break;
+      case Op::kFuncName:
+        dest->append(msg.location.func_name.data(), msg.location.func_name.size());
+        break;
+      case Op::kLine:
+        AppendInt(msg.location.line, dest);
+        break;
+      case Op::kMessage:
+        dest->append(msg.message.data(), msg.message.size());
+        break;
+    }
+  }
 }
-}  // namespace logger
\ No newline at end of file
+}  // namespace logger
@@ -1,13 +1,58 @@
 #pragma once
 
 #include <string.h>
-#include "formatter.h"
+#include <string>
+#include <vector>
 
+#include "formatter.h"
 #include "sys_util.h"
 
 namespace logger {
+/// @brief 按 pattern 输出文本日志，pattern 在设置时编译为操作序列
+/// 支持的标记与解码工具一致：
+/// %l 等级  %D 日期时间  %S 秒级时间戳  %M 毫秒级时间戳  %p 进程 id  %t 线程 id  %n 线程名称
+/// %F 文件名  %f 函数名  %# 行号  %v 日志内容  %% 字符 %
 class DefaultFormatter : public Formatter {
  public:
+  // [2025-04-27 12:00:00] [I] [file.cc:123] [pid:tid] message
+  static constexpr const char* kDefaultPattern = "[%D] [%l] [%F:%#] [%p:%t] %v";
+
+  DefaultFormatter();
+  explicit DefaultFormatter(const std::string& pattern);
+
+  void SetPattern(const std::string& pattern);
+
+  /// @brief 追加到 dest 末尾，dest 容量足够时不会分配内存
+  /// @param msg
+  /// @param dest
   void Format(const LogMsg& msg, std::string* dest) override;
+
+ private:
+  enum class Op : uint8_t {
+    kLiteral,
+    kLevel,
+    kDate,
+    kSeconds,
+    kMilliseconds,
+    kProcessId,
+    kThreadId,
+    kThreadName,
+    kFileName,
+    kFuncName,
+    kLine,
+    kMessage,
+  };
+
+  struct Item {
+    Op op;
+    std::string literal;  // 仅 kLiteral 使用
+  };
+
+  /// @brief 追加一个字面量字符，与前一个字面量合并
+  /// @param ch
+  void AddLiteral_(char ch);
+
+ private:
+  std::vector<Item> items_;
 };
-}  // namespace logger
\ No newline at end of file
+}  // namespace logger
@@ -1,22 +1,143 @@
 #include "effective_formatter.h"
-#include "effective_msg.pb.h"
+
+#include <cstring>
+
 #include "sys_util.h"
 
 namespace logger {
+namespace {
+// 与 effective_msg.proto 中 EffectiveMsg 的字段编号保持一致
+enum FieldNumber : uint32_t {
+  kLevel = 1,
+  kTimestamp = 2,
+  kPid = 3,
+  kTid = 4,
+  kLine = 5,
+  kFileName = 6,
+  kFuncName = 7,
+  kLogInfo = 8,
+  kSiteId = 9,
+  kThreadNameId = 10,
+};
+
+enum WireType : uint32_t {
+  kVarint = 0,
+  kLengthDelimited = 2,
+};
+
+// 字段编号均小于 16，tag 只占一个字节
+constexpr char Tag(FieldNumber field, WireType type) {
+  return static_cast<char>((field << 3) | type);
+}
+
+// tag 1 字节 + varint 最多 10 字节
+constexpr size_t kMaxVarintField = 1 + 10;
+// tag 1 字节 + 长度 varint 最多 5 字节
+constexpr size_t kMaxStringField = 1 + 5;
+
+inline char* WriteVarint(uint64_t value, char* ptr) {
+  while (value >= 0x80) {
+    *ptr++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *ptr++ = static_cast<char>(value);
+  return ptr;
+}
+
+inline bool ReadVarint(const char*& ptr, const char* end, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; ptr != end && shift < 64; shift += 7) {
+    auto byte = static_cast<uint8_t>(*ptr++);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// proto3 不写入默认值，负的 int32 按 64 位符号扩展编码
+inline char* WriteInt32(FieldNumber field, int32_t value, char* ptr) {
+  if (value == 0) {
+    return ptr;
+  }
+  *ptr++ = Tag(field, kVarint);
+  return WriteVarint(static_cast<uint64_t>(static_cast<int64_t>(value)), ptr);
+}
+
+inline char* WriteInt64(FieldNumber field, int64_t value, char* ptr) {
+  if (value == 0) {
+    return ptr;
+  }
+  *ptr++ = Tag(field, kVarint);
+  return WriteVarint(static_cast<uint64_t>(value), ptr);
+}
+
+inline char* WriteUInt32(FieldNumber field, uint32_t value, char* ptr) {
+  if (value == 0) {
+    return ptr;
+  }
+  *ptr++ = Tag(field, kVarint);
+  return WriteVarint(value, ptr);
+}
+
+inline char* WriteString(FieldNumber field, StringView value, char* ptr) {
+  if (value.empty()) {
+    return ptr;
+  }
+  *ptr++ = Tag(field, kLengthDelimited);
+  ptr = WriteVarint(value.size(), ptr);
+  memcpy(ptr, value.data(), value.size());
+  return ptr + value.size();
+}
+}  // namespace
+
+// 直接按 proto3 编码规则写出与 EffectiveMsg::SerializeToArray 相同的字节，
+// 省去构造 EffectiveMsg 以及拷贝字符串的开销，字段按编号升序写入
 void EffectiveFormatter::Format(const LogMsg& msg, std::string* dest) {
-  EffectiveMsg eff_msg;
-  eff_msg.set_level(static_cast<int32_t>(msg.level));
-  eff_msg.set_timestamp(
-      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-          .count());
-  eff_msg.set_pid(GetProcessId());
-  eff_msg.set_tid(GetThreadId());
-  eff_msg.set_line(msg.location.line);
-  eff_msg.set_file_name(msg.location.file_name.data(), msg.location.file_name.size());
-  eff_msg.set_func_name(msg.location.func_name.data(), msg.location.func_name.size());
-  eff_msg.set_log_info(msg.message.data(), msg.message.size());
-  size_t len = eff_msg.ByteSizeLong();
-  dest->resize(len);
-  eff_msg.SerializeToArray(dest->data(), len);
-}
-}  // namespace logger
\ No newline at end of file
+  // 已注册的调用点只记录 id，位置信息由 sink 单独写入
+  bool has_site = msg.location.site_id != 0;
+  StringView file_name = has_site ? StringView() : msg.location.file_name;
+  StringView func_name = has_site ? StringView() : msg.location.func_name;
+  size_t bound = kMaxVarintField * 7 + kMaxStringField * 3 + file_name.size() + func_name.size() + msg.message.size();
+  dest->resize(bound);
+  char* begin = dest->data();
+  char* ptr = begin;
+  ptr = WriteInt32(kLevel, static_cast<int32_t>(msg.level), ptr);
+  ptr = WriteInt64(kTimestamp, msg.WallMs(), ptr);
+  ptr = WriteInt32(kPid, static_cast<int32_t>(GetProcessId()), ptr);
+  ptr = WriteInt32(kTid, static_cast<int32_t>(msg.thread_id), ptr);
+  if (!has_site) {
+    ptr = WriteInt32(kLine, msg.location.line, ptr);
+  }
+  ptr = WriteString(kFileName, file_name, ptr);
+  ptr = WriteString(kFuncName, func_name, ptr);
+  ptr = WriteString(kLogInfo, msg.message, ptr);
+  ptr = WriteUInt32(kSiteId, msg.location.site_id, ptr);
+  ptr = WriteUInt32(kThreadNameId, msg.thread_name_id, ptr);
+  dest->resize(ptr - begin);
+}
+
+StringView EffectiveFormatter::LogInfoOf(const char* data, size_t size) {
+  const char* ptr = data;
+  const char* end = data + size;
+  uint64_t tag = 0;
+  uint64_t value = 0;
+  while (ptr < end && ReadVarint(ptr, end, &tag)) {
+    if ((tag & 7) == kVarint) {
+      if (!ReadVarint(ptr, end, &value)) {
+        break;
+      }
+      continue;
+    }
+    if ((tag & 7) != kLengthDelimited || !ReadVarint(ptr, end, &value) || value > static_cast<uint64_t>(end - ptr)) {
+      break;
+    }
+    if ((tag >> 3) == kLogInfo) {
+      return StringView(ptr, value);
+    }
+    ptr += value;
+  }
+  return StringView();
+}
+}  // namespace logger
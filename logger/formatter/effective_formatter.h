@@ -6,5 +6,11 @@ namespace logger {
 class EffectiveFormatter : public Formatter {
  public:
   void Format(const LogMsg& msg, std::string* dest) override;
+
+  /// @brief 从 Format 写出的数据中取出日志内容，用于建立 chunk 的词索引
+  /// @param data
+  /// @param size
+  /// @return 没有日志内容或数据不完整时为空
+  static StringView LogInfoOf(const char* data, size_t size);
 };
 }  // namespace logger
\ No newline at end of file
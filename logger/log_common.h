@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <string_view>
 
@@ -24,6 +25,16 @@ enum class LogLevel {
   kOff = LOGGER_LEVEL_OFF
 };
 
+namespace detail {
+// 日志等级或全局 handle 变化时递增，使各调用点缓存的等级判断失效(见 LevelCache)
+inline std::atomic<uint32_t> level_generation{1};
+}  // namespace detail
+
+/// @brief 使所有调用点缓存的等级判断失效，需在修改等级之后调用
+inline void InvalidateLevelCache() {
+  detail::level_generation.fetch_add(1, std::memory_order_release);
+}
+
 /// @brief 记录日志出现的文件名、行数、函数名
 struct SourceLocation {
   constexpr SourceLocation() = default;
@@ -46,5 +57,6 @@ struct SourceLocation {
   StringView file_name;
   int32_t line{0};
   StringView func_name;
+  uint32_t site_id{0};  // 静态调用点 id，0 表示未注册(见 call_site.h)
 };
 }  // namespace logger
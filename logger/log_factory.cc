@@ -1,5 +1,7 @@
 #include "log_factory.h"
 
+#include "log_variadic_handle.h"
+
 namespace logger {
 LogFactory::LogFactory() {}
 
@@ -14,5 +16,15 @@ VariadicLogHandle* LogFactory::GetLogHandle() {
 
 void LogFactory::SetLogHandle(std::shared_ptr<VariadicLogHandle> log_handle) {
   log_handle_ = log_handle;
+  InvalidateLevelCache();
+}
+
+bool LevelCache::Refresh_(LogLevel level) {
+  // 先读取 generation 再判断等级，判断期间等级若被修改，generation 也会变化，下次调用会重新判断
+  uint32_t generation = detail::level_generation.load(std::memory_order_acquire) & kGenerationMask;
+  VariadicLogHandle* handle = LogFactory::Instance().GetLogHandle();
+  bool enabled = handle && handle->ShouldLog(level);
+  state_.store((generation << 1) | (enabled ? 1 : 0), std::memory_order_relaxed);
+  return enabled;
 }
 }  // namespace logger
\ No newline at end of file
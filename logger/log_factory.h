@@ -2,9 +2,41 @@
 
 #include <memory>
 
+#include "log_common.h"
+
 namespace logger {
 class VariadicLogHandle;
 
+/// @brief EXT_LOG_* 调用点的等级缓存，缓存全局 handle 是否输出该等级的日志
+/// 缓存与全局 generation 一致时只需两次 relaxed load，不获取 handle、不构造参数
+class LevelCache {
+ public:
+  constexpr LevelCache() = default;
+
+  LevelCache(const LevelCache&) = delete;
+  LevelCache& operator=(const LevelCache&) = delete;
+
+  bool Enabled(LogLevel level) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state >> 1) == (detail::level_generation.load(std::memory_order_relaxed) & kGenerationMask)) {
+      return state & 1;
+    }
+    return Refresh_(level);
+  }
+
+ private:
+  static constexpr uint32_t kGenerationMask = 0x7fffffff;
+
+  /// @brief 重新判断等级并记录当前 generation
+  /// @param level
+  /// @return
+  bool Refresh_(LogLevel level);
+
+ private:
+  // 高 31 位为 generation，最低位表示是否输出
+  std::atomic<uint32_t> state_{0};
+};
+
 class LogFactory {
  public:
   LogFactory(const LogFactory&) = delete;
@@ -7,13 +7,26 @@ LogHandle::LogHandle(LogSinkPtrList sinks) : level_{LogLevel::kInfo}, sinks_{sin
 
 void LogHandle::SetLevel(LogLevel level) {
   level_ = level;
+  InvalidateLevelCache();
 }
 LogLevel LogHandle::GetLevel() const {
   return level_;
 }
 
+void LogHandle::EnableAsync(const AsyncSink::Conf& conf) {
+  for (auto& sink : sinks_) {
+    sink = std::make_shared<AsyncSink>(sink, conf);
+  }
+}
+
+void LogHandle::Flush() {
+  for (auto& sink : sinks_) {
+    sink->Flush();
+  }
+}
+
 void LogHandle::Log(LogLevel level, SourceLocation loc, StringView message) {
-  if (!ShouldLog_(level_)) {
+  if (!ShouldLog_(level)) {
     return;
   }
   LogMsg msg(loc, level, message);
@@ -21,8 +34,29 @@ void LogHandle::Log(LogLevel level, SourceLocation loc, StringView message) {
 }
 
 void LogHandle::Log_(const LogMsg& log_msg) {
+  if (!log_msg.IsDeferred()) {
+    for (auto& sink : sinks_) {
+      sink->Log(log_msg);
+    }
+    return;
+  }
+  // 不支持延迟格式化的 sink 使用格式化后的日志，且只格式化一次
+  std::string message;
+  LogMsg formatted_msg;
+  bool formatted = false;
   for (auto& sink : sinks_) {
-    sink->Log(log_msg);
+    if (sink->AcceptDeferred()) {
+      sink->Log(log_msg);
+      continue;
+    }
+    if (!formatted) {
+      FormatDeferred(log_msg, &message);
+      formatted_msg = log_msg;
+      formatted_msg.message = message;
+      formatted_msg.deferred = DeferredArgs{};
+      formatted = true;
+    }
+    sink->Log(formatted_msg);
   }
 }
 }  // namespace logger
\ No newline at end of file
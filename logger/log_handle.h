@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "log_common.h"
+#include "sinks/async_sink.h"
 #include "sinks/sink.h"
 
 namespace logger {
@@ -27,8 +28,18 @@ class LogHandle {
   void SetLevel(LogLevel level);
   LogLevel GetLevel() const;
 
+  /// @brief 将每个 sink 包装为 AsyncSink，各 sink 拥有独立的队列和 task runner
+  /// 需要在开始写日志之前调用
+  /// @param conf
+  void EnableAsync(const AsyncSink::Conf& conf);
+
+  /// @brief 对所有 sink 调用 Flush，异步模式下会先等待队列清空
+  void Flush();
+
   void Log(LogLevel level, SourceLocation loc, StringView message);
 
+  bool ShouldLog(LogLevel level) const noexcept { return ShouldLog_(level); }
+
  protected:
   bool ShouldLog_(LogLevel level) const noexcept { return level >= level_ && !sinks_.empty(); }
 
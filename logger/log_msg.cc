@@ -1,9 +1,22 @@
 #include "log_msg.h"
 
+#include "sys_util.h"
+#include "thread_name.h"
+
 namespace logger {
 LogMsg::LogMsg(SourceLocation loc, LogLevel lvl, StringView msg)
-    : location(std::move(loc)), level(lvl), message(std::move(msg)) {}
+    : location(std::move(loc)),
+      level(lvl),
+      message(std::move(msg)),
+      ticks(LogClock::NowTicks()),
+      thread_id(GetThreadId()),
+      thread_name_id(GetThreadNameId()) {}
 
 LogMsg::LogMsg(LogLevel lvl, StringView msg)
-    : location(std::move(SourceLocation{})), level(lvl), message(std::move(msg)) {}
-}  // namespace logger
\ No newline at end of file
+    : location(std::move(SourceLocation{})),
+      level(lvl),
+      message(std::move(msg)),
+      ticks(LogClock::NowTicks()),
+      thread_id(GetThreadId()),
+      thread_name_id(GetThreadNameId()) {}
+}  // namespace logger
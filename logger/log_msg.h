@@ -1,10 +1,23 @@
 #pragma once
 
+#include <climits>
+#include <string>
+
+#include "log_clock.h"
 #include "log_common.h"
 
 namespace logger {
 
-/// @brief 日志信息结构体：保存日志位置、等级、内容
+/// @brief 延迟格式化所需的信息：序列化后的 fmt 与参数 args，format 负责还原并格式化到 dest
+/// fmt 与参数一同拷贝，调用方的格式字符串不需要在格式化前一直有效
+struct DeferredArgs {
+  using FormatFunc = void (*)(const char* args, std::string* dest);
+
+  FormatFunc format{nullptr};
+  StringView args;
+};
+
+/// @brief 日志信息结构体：保存日志位置、等级、内容，以及产生日志的时间和线程
 struct LogMsg {
   LogMsg() = default;
   LogMsg(SourceLocation loc, LogLevel lvl, StringView msg);
@@ -13,8 +26,30 @@ struct LogMsg {
   LogMsg(const LogMsg& other) = default;
   LogMsg& operator=(const LogMsg& other) = default;
 
+  /// @brief message 尚未格式化，需要通过 deferred 得到
+  bool IsDeferred() const noexcept { return deferred.format != nullptr; }
+
+  /// @brief 自 epoch 以来的毫秒数，已换算时直接返回 wall_ms
+  /// 各线程的校准点不同，同一条日志需要在多处使用时间时应先换算一次并填入 wall_ms
+  /// @return
+  int64_t WallMs() const { return wall_ms != kUnresolvedWallMs ? wall_ms : LogClock::TicksToWallMs(ticks); }
+
+  static constexpr int64_t kUnresolvedWallMs = INT64_MIN;
+
   SourceLocation location;
   LogLevel level;
   StringView message;
+  uint64_t ticks{0};  // LogClock 原始计数，通过 LogClock::TicksToWallNs 换算为墙上时间
+  int64_t wall_ms{kUnresolvedWallMs};  // 已换算的墙上时间，未换算时为 kUnresolvedWallMs
+  size_t thread_id{0};
+  uint32_t thread_name_id{0};  // 通过 SetThreadName 设置的线程名称 id，未设置时为 0
+  DeferredArgs deferred;
 };
-}  // namespace logger
\ No newline at end of file
+
+/// @brief 将延迟格式化的日志内容追加到 dest
+/// @param msg
+/// @param dest
+inline void FormatDeferred(const LogMsg& msg, std::string* dest) {
+  msg.deferred.format(msg.deferred.args.data(), dest);
+}
+}  // namespace logger
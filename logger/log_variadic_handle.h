@@ -1,6 +1,7 @@
 #pragma once
 
 #include <fmt/core.h>
+#include "deferred_args.h"
 #include "log_handle.h"
 
 namespace logger {
@@ -18,9 +19,15 @@ class VariadicLogHandle : public LogHandle {
     Log(SourceLocation{}, lvl, fmt, std::forward<Args>(args)...);
   }
 
+  /// @brief 开启后调用线程只序列化参数，格式化推迟到支持延迟格式化的 sink 的后台线程
+  /// 要求 SourceLocation 中的字符串具有静态生命周期(通过日志宏调用时满足)，fmt 与参数一同拷贝
+  /// @param deferred
+  void SetDeferred(bool deferred) { deferred_.store(deferred, std::memory_order_relaxed); }
+
  private:
   /// @brief 整体作用是将 loc lvl 以及 fmt 格式的字符串赋值给 msg
   /// fmt vformat_to 用于组合 LOG("Hello {}", "wang")
+  /// 延迟模式下参数全部可序列化时，只拷贝参数，不进行格式化
   /// @tparam ...Args
   /// @param loc
   /// @param lvl
@@ -31,10 +38,24 @@ class VariadicLogHandle : public LogHandle {
     if (!ShouldLog_(lvl)) {
       return;
     }
+    if constexpr (detail::DeferredCodec<Args...>::kDeferrable) {
+      if (deferred_.load(std::memory_order_relaxed)) {
+        fmt::basic_memory_buffer<char, 256> args_buf;
+        detail::DeferredCodec<Args...>::Encode(args_buf, StringView(fmt.data(), fmt.size()), args...);
+        LogMsg msg(loc, lvl, StringView());
+        msg.deferred.format = &detail::DeferredCodec<Args...>::Format;
+        msg.deferred.args = StringView(args_buf.data(), args_buf.size());
+        LogHandle::Log_(msg);
+        return;
+      }
+    }
     fmt::basic_memory_buffer<char, 256> buf;
     fmt::detail::vformat_to(buf, fmt, fmt::make_format_args(std::forward<Args>(args)...));
     LogMsg msg(loc, lvl, StringView(buf.data(), buf.size()));
     LogHandle::Log_(msg);
   }
+
+ private:
+  std::atomic<bool> deferred_{false};
 };
-}  // namespace logger
\ No newline at end of file
+}  // namespace logger
@@ -1,19 +1,27 @@
 #pragma once
+#include "call_site.h"
 #include "log_factory.h"
 
 using namespace logger;
 
 #define EXT_LOGGER_INIT(handle) logger::LogFactory::Instance().SetLogHandle(handle)
 
-#define LOGGER_CALL(handle, level, ...)                                                                      \
-  if (handle) {                                                                                              \
-    (handle)->Log(logger::SourceLocation{__FILE__, __LINE__, static_cast<const char*>(__FUNCTION__)}, level, \
-                  __VA_ARGS__);                                                                              \
+// 调用点信息只在首次执行时注册一次，之后的调用直接使用静态的 SourceLocation
+#define LOGGER_CALL(handle, level, ...)                                                       \
+  if (handle) {                                                                               \
+    static const logger::SourceLocation _logger_call_site =                                   \
+        logger::RegisterCallSite(__FILE__, __LINE__, static_cast<const char*>(__FUNCTION__)); \
+    (handle)->Log(_logger_call_site, level, __VA_ARGS__);                                     \
   }
 
+// 全局 handle 的调用点先检查静态的等级缓存，不输出时不会获取 handle，也不会对参数求值
+#define EXT_LOGGER_CALL(level, ...)                                                      \
+  if (static logger::LevelCache _logger_level_cache; _logger_level_cache.Enabled(level)) \
+  LOGGER_CALL(logger::LogFactory::Instance().GetLogHandle(), level, __VA_ARGS__)
+
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_TRACE
 #define LOG_LOGGER_TRACE(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kTrace, __VA_ARGS__)
-#define EXT_LOG_TRACE(...) LOG_LOGGER_TRACE(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_TRACE(...) EXT_LOGGER_CALL(logger::LogLevel::kTrace, __VA_ARGS__)
 #else
 #define LOG_LOGGER_TRACE(handle, ...) (void)0
 #define EXT_LOG_TRACE(...) (void)0
@@ -21,7 +29,7 @@ using namespace logger;
 
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_DEBUG
 #define LOG_LOGGER_DEBUG(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kDebug, __VA_ARGS__)
-#define EXT_LOG_DEBUG(...) LOG_LOGGER_DEBUG(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_DEBUG(...) EXT_LOGGER_CALL(logger::LogLevel::kDebug, __VA_ARGS__)
 #else
 #define LOG_LOGGER_DEBUG(handle, ...) (void)0
 #define EXT_LOG_DEBUG(...) (void)0
@@ -29,7 +37,7 @@ using namespace logger;
 
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_INFO
 #define LOG_LOGGER_INFO(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kInfo, __VA_ARGS__)
-#define EXT_LOG_INFO(...) LOG_LOGGER_INFO(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_INFO(...) EXT_LOGGER_CALL(logger::LogLevel::kInfo, __VA_ARGS__)
 #else
 #define LOG_LOGGER_INFO(handle, ...) (void)0
 #define EXT_LOG_INFO(...) (void)0
@@ -37,7 +45,7 @@ using namespace logger;
 
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_WARN
 #define LOG_LOGGER_WARN(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kWarn, __VA_ARGS__)
-#define EXT_LOG_WARN(...) LOG_LOGGER_WARN(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_WARN(...) EXT_LOGGER_CALL(logger::LogLevel::kWarn, __VA_ARGS__)
 #else
 #define LOG_LOGGER_WARN(handle, ...) (void)0
 #define EXT_LOG_WARN(...) (void)0
@@ -45,7 +53,7 @@ using namespace logger;
 
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_ERROR
 #define LOG_LOGGER_ERROR(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kError, __VA_ARGS__)
-#define EXT_LOG_ERROR(...) LOG_LOGGER_ERROR(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_ERROR(...) EXT_LOGGER_CALL(logger::LogLevel::kError, __VA_ARGS__)
 #else
 #define LOG_LOGGER_ERROR(handle, ...) (void)0
 #define EXT_LOG_ERROR(...) (void)0
@@ -53,7 +61,7 @@ using namespace logger;
 
 #if LOGGER_ACTIVE_LEVEL <= LOGGER_LEVEL_CRITICAL
 #define LOG_LOGGER_CRITICAL(handle, ...) LOGGER_CALL(handle, logger::LogLevel::kFatal, __VA_ARGS__)
-#define EXT_LOG_CRITICAL(...) LOG_LOGGER_CRITICAL(logger::LogFactory::Instance().GetLogHandle(), __VA_ARGS__)
+#define EXT_LOG_CRITICAL(...) EXT_LOGGER_CALL(logger::LogLevel::kFatal, __VA_ARGS__)
 #else
 #define LOG_LOGGER_CRITICAL(handle, ...) (void)0
 #define EXT_LOG_CRITICAL(...) (void)0
@@ -72,7 +72,7 @@ void MmapAux::Clear() {
   Header_()->size = 0;
 }
 
-inline size_t MmapAux::GetSize() const {
+size_t MmapAux::GetSize() const {
   if (!IsValid_()) {
     return 0;
   }
@@ -121,7 +121,7 @@ MmapAux::MmapHeader* MmapAux::Header_() const {
   return static_cast<MmapHeader*>(handle_);
 }
 
-inline size_t MmapAux::GetCapacity_() const noexcept {
+size_t MmapAux::GetCapacity_() const noexcept {
   return capacity_;
 }
 };  // namespace logger
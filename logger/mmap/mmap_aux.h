@@ -42,6 +42,10 @@ class MmapAux {
 
   bool Empty() const;
 
+  /// @brief 将映射内存的内容同步到文件
+  /// @param async 为 true 时只发起回写，不等待完成
+  void Sync(bool async);
+
  private:
   // mmap 的 head
   struct MmapHeader {
@@ -72,9 +76,6 @@ class MmapAux {
   /// @brief 取消当前内存空间和文件的映射
   void Unmap_();
 
-  /// @brief 将当前内存空间的内容同步到文件
-  void Sync_();
-
   /// @brief 对比 magic 以查看数据是否被篡改
   /// @return
   bool IsValid_() const;
@@ -5,6 +5,7 @@
 
 #include "defer.h"
 #include "mmap_aux.h"
+#include "mmap_ring.h"
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -44,9 +45,50 @@ void MmapAux::Unmap_() {
 }
 
 // 将内存内容同步到文件
-void MmapAux::Sync_() {
+void MmapAux::Sync(bool async) {
   if (handle_) {
-    msync(handle_, capacity_, MS_SYNC);
+    msync(handle_, capacity_, async ? MS_ASYNC : MS_SYNC);
   }
 }
-};  // namespace logger
\ No newline at end of file
+
+bool MmapRing::TryMap_(size_t size, bool populate) {
+  int fd = open(file_path_.string().c_str(), O_RDWR | O_CREAT, S_IRWXU);
+  LOG_DEFER {
+    if (fd != -1) {
+      close(fd);
+    }
+  };
+  if (fd == -1 || ftruncate(fd, size) != 0) {
+    return false;
+  }
+  // MAP_POPULATE 在映射时即建立全部页表，之后写入不会因缺页阻塞
+  int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+  void* handle = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+  if (handle == MAP_FAILED) {
+    return false;
+  }
+  handle_ = handle;
+  map_size_ = size;
+  if (populate) {
+    madvise(handle_, map_size_, MADV_WILLNEED);
+  }
+  return true;
+}
+
+void MmapRing::Sync(bool async) {
+  if (handle_) {
+    msync(handle_, map_size_, async ? MS_ASYNC : MS_SYNC);
+  }
+}
+
+void MmapRing::Unmap_() {
+  if (handle_) {
+    munmap(handle_, map_size_);
+  }
+  handle_ = nullptr;
+  header_ = nullptr;
+  data_ = nullptr;
+  map_size_ = 0;
+  capacity_ = 0;
+}
+};  // namespace logger
@@ -0,0 +1,77 @@
+#include "mmap_ring.h"
+
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include "file_util.h"
+#include "sys_util.h"
+
+namespace logger {
+MmapRing::MmapRing(fpath file_path, size_t capacity, bool populate) : file_path_(std::move(file_path)) {
+  if (!std::filesystem::exists(file_path_)) {
+    std::filesystem::create_directories(file_path_.parent_path());
+    std::ofstream ofs(file_path_, std::ios::out | std::ios::binary);
+    ofs.close();
+  }
+  size_t page_size = GetPageSize();
+  size_t map_size = (sizeof(RingHeader) + capacity + page_size - 1) / page_size * page_size;
+  // 不缩小已有文件，其中可能有容量更大的未消费数据
+  map_size = std::max(map_size, fs::GetFileSize(file_path_));
+  if (!TryMap_(map_size, populate)) {
+    Unmap_();
+    return;
+  }
+  header_ = static_cast<RingHeader*>(handle_);
+  bool has_data = header_->magic == RingHeader::kMagic && header_->head != header_->tail &&
+                  header_->capacity + sizeof(RingHeader) <= map_size &&
+                  header_->head - header_->tail <= header_->capacity;
+  if (!has_data) {
+    header_->magic = RingHeader::kMagic;
+    header_->reserved = 0;
+    header_->capacity = map_size - sizeof(RingHeader);
+    header_->head = 0;
+    header_->tail = 0;
+  }
+  capacity_ = header_->capacity;
+  data_ = static_cast<uint8_t*>(handle_) + sizeof(RingHeader);
+}
+
+MmapRing::~MmapRing() {
+  Unmap_();
+}
+
+bool MmapRing::Push(const void* data, size_t size) {
+  if (size > Available()) {
+    return false;
+  }
+  Write(header_->head, data, size);
+  // 先写数据再前移 head，进程崩溃时不会留下不完整的数据
+  header_->head += size;
+  return true;
+}
+
+void MmapRing::Write(uint64_t pos, const void* data, size_t size) {
+  size_t offset = pos % capacity_;
+  size_t first = std::min(size, capacity_ - offset);
+  memcpy(data_ + offset, data, first);
+  memcpy(data_, static_cast<const uint8_t*>(data) + first, size - first);
+}
+
+void MmapRing::Read(uint64_t pos, void* data, size_t size) const {
+  size_t offset = pos % capacity_;
+  size_t first = std::min(size, capacity_ - offset);
+  memcpy(data, data_ + offset, first);
+  memcpy(static_cast<uint8_t*>(data) + first, data_, size - first);
+}
+
+void MmapRing::Peek(uint64_t pos, size_t size, StringView* first, StringView* second) const {
+  size_t offset = pos % capacity_;
+  size_t first_size = std::min(size, capacity_ - offset);
+  *first = StringView(reinterpret_cast<const char*>(data_ + offset), first_size);
+  *second = StringView(reinterpret_cast<const char*>(data_), size - first_size);
+}
+
+void MmapRing::Consume(size_t size) {
+  header_->tail += std::min(size, Size());
+}
+}  // namespace logger
@@ -0,0 +1,104 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+
+#include "log_common.h"
+
+namespace logger {
+/// @brief 固定容量的环形 mmap：创建时一次性映射，之后的写入不会重新映射
+/// header 中的 head、tail 为从 0 开始单调递增的位置，对容量取模得到数据区中的偏移
+/// 写入者在 head 追加数据，消费者从 tail 读出后前移 tail，进程退出后未消费的数据仍保存在文件中
+class MmapRing {
+  using fpath = std::filesystem::path;
+
+ public:
+  /// @brief 映射文件，文件中有未消费的数据时沿用其容量，保证数据完整
+  /// @param file_path
+  /// @param capacity 数据区容量
+  /// @param populate 是否预先载入全部页面，避免写入时触发缺页
+  MmapRing(fpath file_path, size_t capacity, bool populate);
+  ~MmapRing();
+
+  MmapRing(const MmapRing&) = delete;
+  MmapRing& operator=(const MmapRing&) = delete;
+
+  /// @brief 映射失败时为 false，此时不能调用其他接口
+  /// @return
+  bool IsValid() const noexcept { return data_ != nullptr; }
+
+  size_t Capacity() const noexcept { return capacity_; }
+
+  uint64_t Head() const noexcept { return header_->head; }
+
+  uint64_t Tail() const noexcept { return header_->tail; }
+
+  /// @brief 尚未消费的数据大小
+  /// @return
+  size_t Size() const noexcept { return header_->head - header_->tail; }
+
+  size_t Available() const noexcept { return capacity_ - Size(); }
+
+  bool Empty() const noexcept { return header_->head == header_->tail; }
+
+  /// @brief 在 head 追加数据
+  /// @param data
+  /// @param size
+  /// @return 剩余空间不足时返回 false，不写入任何数据
+  bool Push(const void* data, size_t size);
+
+  /// @brief 覆盖 [pos, pos + size) 中已写入的数据，用于回填 header
+  /// @param pos 位于 [tail, head) 中
+  /// @param data
+  /// @param size
+  void Write(uint64_t pos, const void* data, size_t size);
+
+  /// @brief 读取 [pos, pos + size) 中的数据
+  /// @param pos 位于 [tail, head) 中
+  /// @param data
+  /// @param size
+  void Read(uint64_t pos, void* data, size_t size) const;
+
+  /// @brief 获取 [pos, pos + size) 中的数据，跨越数据区末尾时分为两段
+  /// @param pos 位于 [tail, head) 中
+  /// @param size
+  /// @param first
+  /// @param second 未跨越末尾时为空
+  void Peek(uint64_t pos, size_t size, StringView* first, StringView* second) const;
+
+  /// @brief 消费从 tail 开始的 size 字节
+  /// @param size 不大于 Size()
+  void Consume(size_t size);
+
+  /// @brief 将映射内存的内容同步到文件
+  /// @param async 为 true 时只发起回写，不等待完成
+  void Sync(bool async);
+
+ private:
+  struct RingHeader {
+    static constexpr uint32_t kMagic = 0x3ffe;
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t tail;
+  };
+
+ private:
+  /// @brief 和文件建立映射，文件大小调整为 size
+  /// @param size 映射空间大小
+  /// @param populate
+  /// @return
+  bool TryMap_(size_t size, bool populate);
+
+  /// @brief 取消映射
+  void Unmap_();
+
+ private:
+  fpath file_path_;
+  void* handle_ = nullptr;
+  size_t map_size_ = 0;
+  RingHeader* header_ = nullptr;
+  uint8_t* data_ = nullptr;
+  size_t capacity_ = 0;
+};
+}  // namespace logger
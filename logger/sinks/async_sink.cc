@@ -0,0 +1,90 @@
+#include "async_sink.h"
+
+#include "context.h"
+
+namespace logger {
+AsyncSink::AsyncSink(std::shared_ptr<LogSink> sink, Conf conf) : sink_(std::move(sink)), conf_(conf) {
+  if (conf_.queue_size == 0) {
+    conf_.queue_size = 1;
+  }
+  pending_.resize(conf_.queue_size);
+  processing_.resize(conf_.queue_size);
+  task_runner_ = NEW_TASK_RUNNER(654321);
+}
+
+AsyncSink::~AsyncSink() {
+  POST_TASK(task_runner_, [this]() { Drain_(); });
+  WAIT_TASK_IDLE(task_runner_);
+}
+
+void AsyncSink::Log(const LogMsg& msg) {
+  bool post = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_count_ == conf_.queue_size) {
+      bool drop = conf_.policy == OverflowPolicy::kDropNewest ||
+                  (conf_.policy == OverflowPolicy::kDropBelowLevel && msg.level < conf_.drop_level);
+      if (drop) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      not_full_.wait(lock, [this]() { return pending_count_ < conf_.queue_size; });
+    }
+    Entry& entry = pending_[pending_count_++];
+    entry.msg = msg;
+    if (msg.IsDeferred()) {
+      entry.payload.assign(msg.deferred.args.data(), msg.deferred.args.size());
+    } else {
+      entry.payload.assign(msg.message.data(), msg.message.size());
+    }
+    post = !drain_posted_;
+    drain_posted_ = true;
+  }
+  if (post) {
+    POST_TASK(task_runner_, [this]() { Drain_(); });
+  }
+}
+
+void AsyncSink::Drain_() {
+  size_t count = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(pending_, processing_);
+    count = pending_count_;
+    pending_count_ = 0;
+    drain_posted_ = false;
+  }
+  not_full_.notify_all();
+  for (size_t i = 0; i < count; ++i) {
+    LogMsg& msg = processing_[i].msg;
+    const std::string& payload = processing_[i].payload;
+    if (!msg.IsDeferred()) {
+      msg.message = payload;
+    } else if (sink_->AcceptDeferred()) {
+      msg.deferred.args = payload;
+    } else {
+      msg.deferred.args = payload;
+      message_buf_.clear();
+      FormatDeferred(msg, &message_buf_);
+      msg.message = message_buf_;
+      msg.deferred = DeferredArgs{};
+    }
+    sink_->Log(msg);
+  }
+}
+
+void AsyncSink::SetFormatter(std::unique_ptr<Formatter> formatter) {
+  // 在 task runner 上替换，避免与正在处理的日志竞争
+  POST_TASK(task_runner_, [&]() {
+    Drain_();
+    sink_->SetFormatter(std::move(formatter));
+  });
+  WAIT_TASK_IDLE(task_runner_);
+}
+
+void AsyncSink::Flush() {
+  POST_TASK(task_runner_, [this]() { Drain_(); });
+  WAIT_TASK_IDLE(task_runner_);
+  sink_->Flush();
+}
+}  // namespace logger
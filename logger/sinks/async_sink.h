@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "executor.h"
+#include "sink.h"
+
+namespace logger {
+/// @brief 异步 sink：调用线程只将日志放入有界队列，由独立的 task runner 调用被包装的 sink
+/// 用于隔离慢速 sink(如 ConsoleSink)，使其不会增加调用线程以及其他 sink 的延迟
+class AsyncSink final : public LogSink {
+ public:
+  /// @brief 队列已满时的处理策略
+  enum class OverflowPolicy {
+    kBlock,           // 阻塞等待队列有空位
+    kDropNewest,      // 丢弃当前日志
+    kDropBelowLevel,  // 丢弃低于 drop_level 的日志，其余日志阻塞等待
+  };
+
+  struct Conf {
+    size_t queue_size{8192};  // 队列中最多缓存的日志条数
+    OverflowPolicy policy{OverflowPolicy::kBlock};
+    LogLevel drop_level{LogLevel::kWarn};
+  };
+
+  AsyncSink(std::shared_ptr<LogSink> sink, Conf conf);
+
+  /// @brief 等待队列中剩余的日志写入被包装的 sink
+  ~AsyncSink() override;
+
+  void Log(const LogMsg& msg) override;
+
+  void SetFormatter(std::unique_ptr<Formatter> formatter) override;
+
+  /// @brief 等待队列清空，再调用被包装 sink 的 Flush
+  void Flush() override;
+
+  /// @brief 延迟格式化的日志只拷贝参数，在 task runner 上按被包装 sink 的需要格式化
+  bool AcceptDeferred() const override { return true; }
+
+  /// @brief 因队列已满而被丢弃的日志条数
+  uint64_t GetDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  // 队列中的日志，payload 保存 message 或延迟格式化的参数，LogMsg 中对应的 StringView 在取出时重新指向 payload
+  struct Entry {
+    LogMsg msg;
+    std::string payload;
+  };
+
+  /// @brief 在 task runner 上运行，取出当前队列中全部日志交给被包装的 sink
+  void Drain_();
+
+ private:
+  std::shared_ptr<LogSink> sink_;
+  Conf conf_;
+  TaskRunnerTag task_runner_;
+
+  // 生产者写入 pending_，Drain_ 与 processing_ 整体交换，Entry 中的字符串可以复用已分配的内存
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::vector<Entry> pending_;
+  size_t pending_count_{0};
+  bool drain_posted_{false};
+  std::vector<Entry> processing_;
+  std::string message_buf_;
+
+  std::atomic<uint64_t> dropped_{0};
+};
+}  // namespace logger
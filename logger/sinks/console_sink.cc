@@ -4,7 +4,9 @@ namespace logger {
 ConsoleSink::ConsoleSink() : formatter_(std::make_unique<DefaultFormatter>()) {}
 
 void ConsoleSink::Log(const LogMsg& msg) {
-  std::string buf;
+  // 复用线程局部缓冲区，避免每条日志分配内存
+  static thread_local std::string buf;
+  buf.clear();
   formatter_->Format(msg, &buf);
   // fwrite(buf.data(), 1, buf.size(), stdout);
   // fwrite("\n", 1, 1, stdout);
@@ -14,4 +16,4 @@ void ConsoleSink::Log(const LogMsg& msg) {
 void ConsoleSink::SetFormatter(std::unique_ptr<Formatter> formatter) {
   formatter_ = std::move(formatter);
 }
-}  // namespace logger
\ No newline at end of file
+}  // namespace logger
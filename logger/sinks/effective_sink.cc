@@ -1,20 +1,34 @@
 #include "effective_sink.h"
 
+#include <cstdint>
 #include <cstring>
 #include <fstream>
+#include <thread>
+#include <unordered_map>
 
 #include "aes_crypt.h"
+#include "call_site.h"
 #include "context.h"
 #include "effective_formatter.h"
 #include "file_util.h"
 #include "internal_log.h"
 #include "sys_util.h"
+#include "thread_name.h"
 #include "timer_counter.h"
+#include "token_bloom.h"
 #include "zstd_compress.h"
 
+#include "effective_msg.pb.h"
+
 namespace logger {
 
-EffectiveSink::EffectiveSink(Conf conf) : conf_(std::move(conf)) {
+static std::atomic<uint64_t> g_sink_id{1};
+
+EffectiveSink::EffectiveSink(Conf conf)
+    : conf_(std::move(conf)),
+      id_(g_sink_id++),
+      level_controller_(LevelController::Conf{conf_.min_compression_level, conf_.compression_level,
+                                              conf_.compress_cpu_budget}) {
   // 创建新的日志文件，打印必要信息
   LOG_INFO("EffectiveSink: dir = {}, prefix = {}, pub_key = {}, interval = {}, single_size = {}, total_size = {}",
            conf_.dir.string(), conf_.prefix, conf_.pub_key, conf.interval.count(), conf_.single_size.count(),
@@ -23,7 +37,10 @@ EffectiveSink::EffectiveSink(Conf conf) : conf_(std::move(conf)) {
   if (!std::filesystem::exists(conf_.dir)) {
     std::filesystem::create_directories(conf_.dir);
   }
+  // 只在启动时遍历一次目录，之后由 flush_runner_ 维护
+  file_index_.Load(conf_.dir, conf_.save_index ? conf_.dir / (conf_.prefix + ".index") : std::filesystem::path());
   task_runner_ = NEW_TASK_RUNNER(123456);
+  flush_runner_ = NEW_TASK_RUNNER(123458);
   formatter_ = std::make_unique<EffectiveFormatter>();
   // 获取公钥和私钥
   auto ecdh_key = crypt::GenECDHKey();
@@ -33,79 +50,240 @@ EffectiveSink::EffectiveSink(Conf conf) : conf_(std::move(conf)) {
   std::string server_pub_key_bin = crypt::HexKeyToBinary(conf_.pub_key);
   // server_pub 和自己的私钥生成用于 AES 加密的私钥
   std::string shared_secret = crypt::GenECDHSharedSecret(client_pri, server_pub_key_bin);
-  crypt_ = std::make_unique<crypt::AESCrypt>(shared_secret);
+  crypt_ = std::make_unique<crypt::AESCtrCrypt>(shared_secret);
+  if (conf_.token_bloom && conf_.compress_workers == 0) {
+    hasher_ = std::make_unique<crypt::TokenHasher>(shared_secret);
+  }
 
   compress_ = std::make_unique<ZstdCompress>();
-
-  master_cache_ = std::make_unique<MmapAux>(conf_.dir / "master_cache");
-  slave_cache_ = std::make_unique<MmapAux>(conf_.dir / "slave_cache");
-  if (!master_cache_ || !slave_cache_) {
-    throw std::runtime_error("EffectiveSink::EffectiveSink: create mmap failed");
+  compress_->SetLevel(conf_.compression_level);
+  metrics_.compression_level.store(compress_->GetLevel());
+  std::string dict;
+  if (!conf_.dict_path.empty()) {
+    std::ifstream ifs(conf_.dict_path, std::ios::binary);
+    dict.assign((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    dict_id_ = compress_->SetDictionary(dict.data(), dict.size());
+    if (dict_id_ == 0) {
+      LOG_ERROR("EffectiveSink: load dictionary failed, path = {}", conf_.dict_path.string());
+    }
+  }
+  // 每个工作线程使用独立的压缩、加密对象，密钥与字典和 task_runner_ 上的相同
+  workers_.resize(conf_.compress_workers);
+  for (auto& worker : workers_) {
+    worker.runner = NEW_TASK_RUNNER(123457);
+    worker.crypt = std::make_unique<crypt::AESCtrCrypt>(shared_secret);
+    if (conf_.token_bloom) {
+      worker.hasher = std::make_unique<crypt::TokenHasher>(shared_secret);
+    }
+    worker.compress = std::make_unique<ZstdCompress>();
+    worker.compress->SetLevel(conf_.compression_level);
+    if (dict_id_ != 0) {
+      worker.compress->SetDictionary(dict.data(), dict.size());
+    }
   }
 
-  // 保证 slave_cache 为空
-  if (!slave_cache_->Empty()) {
-    is_slave_free_.store(true);
-    POST_TASK(task_runner_, [this]() { CacheToFile_(); });
-    WAIT_TASK_IDLE(task_runner_);
+  // 两种 cache 模式二选一，另一种模式遗留的数据也在此写入文件
+  auto ring_path = conf_.dir / "ring_cache";
+  if (conf_.ring_cache || std::filesystem::exists(ring_path)) {
+    ring_cache_ = std::make_unique<MmapRing>(ring_path, space_cast<bytes>(conf_.ring_size).count(),
+                                             conf_.ring_cache && conf_.prefault_cache);
+    if (!ring_cache_->IsValid()) {
+      throw std::runtime_error("EffectiveSink::EffectiveSink: create ring mmap failed");
+    }
+    // 保证环形 cache 为空
+    if (!ring_cache_->Empty()) {
+      POST_TASK(flush_runner_, [this]() { RecoverRing_(); });
+      WAIT_TASK_IDLE(flush_runner_);
+    }
+    chunk_start_ = ring_cache_->Head();
+    if (!conf_.ring_cache) {
+      ring_cache_.reset();
+    }
+  }
+  // 段数减少时，多出的段中可能仍有遗留数据，一并打开
+  size_t segment_count = conf_.ring_cache ? 0 : std::max<size_t>(conf_.cache_segments, 2);
+  while (segments_.size() < segment_count || std::filesystem::exists(SegmentPath_(segments_.size()))) {
+    segments_.push_back(std::make_unique<MmapAux>(SegmentPath_(segments_.size())));
   }
-  // 保证 master_cache 为空，若不为空则和从 cache 交换，然后和上一步一样
-  if (!master_cache_->Empty()) {
-    if (is_slave_free_.load()) {
-      is_slave_free_.store(false);
-      SwapCache_();
+  if (!segments_.empty()) {
+    // 保证所有 cache 段为空，按修改时间先后写入文件，尽量保持 chunk 的顺序
+    std::vector<MmapAux*> dirty;
+    std::vector<std::filesystem::file_time_type> times;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      if (!segments_[i]->Empty()) {
+        dirty.push_back(segments_[i].get());
+        times.push_back(std::filesystem::last_write_time(SegmentPath_(i)));
+      }
     }
-    POST_TASK(task_runner_, [this]() { CacheToFile_(); });
-    WAIT_TASK_IDLE(task_runner_);
+    std::vector<size_t> order(dirty.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&times](size_t lhs, size_t rhs) { return times[lhs] < times[rhs]; });
+    for (size_t i : order) {
+      MmapAux* segment = dirty[i];
+      auto task = [this, segment]() { SegmentToFile_(segment, std::string()); };
+      POST_TASK(flush_runner_, std::move(task));
+    }
+    WAIT_TASK_IDLE(flush_runner_);
+    if (conf_.ring_cache) {
+      segments_.clear();
+    } else {
+      master_cache_ = segments_.front().get();
+      for (size_t i = segments_.size() - 1; i > 0; --i) {
+        free_segments_.push_back(segments_[i].get());
+      }
+    }
+  }
+  // 设置日志文件存活时间，每隔一段时间运行一次，与文件写入在同一线程上
+  elimate_task_id_ = POST_REPEATED_TASK(flush_runner_, [this]() { ElimateFiles_(); }, conf_.interval, -1);
+  if (conf_.durability != Durability::kNone) {
+    sync_task_id_ = POST_REPEATED_TASK(task_runner_, [this]() { SyncCache_(true); }, conf_.sync_interval, -1);
+  }
+  // 日志较少时块迟迟不满，定期将暂存缓冲区和未满的块写入 cache，崩溃时最多丢失约 seal_interval 内的日志
+  if (conf_.seal_interval.count() > 0) {
+    auto task = [this]() {
+      Drain_();
+      SealBlock_();
+    };
+    seal_task_id_ = POST_REPEATED_TASK(task_runner_, std::move(task), conf_.seal_interval, -1);
   }
-  // 设置日志文件存活时间，每隔一段时间运行一次
-  POST_REPEATED_TASK(task_runner_, [this]() { ElimateFiles_(); }, conf_.interval, -1);
 }
 
-void EffectiveSink::ElimateFiles_() {
-  LOG_INFO("EffectiveSink::ElimateFiles_: start");
-  std::vector<std::filesystem::path> files;
-  for (auto& p : std::filesystem::directory_iterator(conf_.dir)) {
-    if (p.path().extension() == ".log") {
-      files.push_back(p.path());
-    }
+EffectiveSink::~EffectiveSink() {
+  // 取消后已投递到 task_runner_、flush_runner_ 的任务在下面等待空闲时执行完毕
+  CANCEL_REPEATED_TASK(elimate_task_id_);
+  if (conf_.durability != Durability::kNone) {
+    CANCEL_REPEATED_TASK(sync_task_id_);
   }
-
-  std::sort(files.begin(), files.end(), [](const std::filesystem::path& lhs, const std::filesystem::path& rhs) {
-    return std::filesystem::last_write_time(lhs) > std::filesystem::last_write_time(rhs);
+  if (conf_.seal_interval.count() > 0) {
+    CANCEL_REPEATED_TASK(seal_task_id_);
+  }
+  POST_TASK(task_runner_, [this]() {
+    Drain_();
+    SealBlock_();
+    CommitBlocks_(0);
   });
+  WAIT_TASK_IDLE(task_runner_);
+  // 工作线程完成块之后还会向 task_runner_ 投递任务，等待这些任务执行完毕
+  for (auto& worker : workers_) {
+    WAIT_TASK_IDLE(worker.runner);
+  }
+  WAIT_TASK_IDLE(task_runner_);
+  POST_TASK(flush_runner_, [this]() { file_index_.Save(); });
+  WAIT_TASK_IDLE(flush_runner_);
+}
 
-  size_t total_bytes = space_cast<bytes>(conf_.total_size).count();
-  size_t used_bytes = 0;
+std::filesystem::path EffectiveSink::SegmentPath_(size_t index) const {
+  if (index == 0) {
+    return conf_.dir / "master_cache";
+  }
+  if (index == 1) {
+    return conf_.dir / "slave_cache";
+  }
+  return conf_.dir / ("cache_" + std::to_string(index));
+}
+
+void EffectiveSink::ElimateFiles_() {
+  LOG_INFO("EffectiveSink::ElimateFiles_: start");
+  auto files = file_index_.Evict(space_cast<bytes>(conf_.total_size).count());
   for (auto& file : files) {
-    used_bytes += fs::GetFileSize(file);
-    if (used_bytes > total_bytes) {
-      LOG_INFO("EffectiveSink::ElimateFiles_: remove file={}", file.string());
-      std::filesystem::remove(file);
+    LOG_INFO("EffectiveSink::ElimateFiles_: remove file={}", file.string());
+    if (file == file_writer_.Path()) {
+      file_writer_.Close();
+      log_file_path_.clear();
     }
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+  }
+  if (!files.empty()) {
+    file_index_.Save();
   }
 }
 
-void EffectiveSink::CacheToFile_() {
-  if (is_slave_free_.load()) {
+void EffectiveSink::SegmentToFile_(MmapAux* segment, const std::string& bloom) {
+  if (segment->Empty()) {
     return;
   }
-  if (slave_cache_->Empty()) {
-    is_slave_free_.store(true);
-    return;
+  StringView data(reinterpret_cast<char*>(segment->Data()), segment->GetSize());
+  uint64_t magic = 0;
+  memcpy(&magic, data.data(), std::min(sizeof(magic), data.size()));
+  if (detail::ChunkHeader::IsCtr(magic)) {
+    // cache 起始位置已有 ChunkHeader，更新 size 后整体写入
+    detail::ChunkHeader* chunk_header = reinterpret_cast<detail::ChunkHeader*>(segment->Data());
+    chunk_header->size = data.size() + bloom.size() - sizeof(detail::ChunkHeader);
+    StringView parts[] = {data, bloom};
+    WriteToFile_(parts, 2);
+  } else {
+    detail::ChunkHeader chunk_header;
+    chunk_header.magic = detail::ChunkHeader::MagicOf(data.data(), data.size());
+    chunk_header.size = data.size();
+    memcpy(chunk_header.pub_key, client_pub_key_.data(),
+           std::min(client_pub_key_.size(), sizeof(chunk_header.pub_key)));
+    StringView parts[] = {StringView(reinterpret_cast<char*>(&chunk_header), sizeof(chunk_header)), data};
+    WriteToFile_(parts, 2);
   }
+  segment->Clear();
+}
+
+void EffectiveSink::RingToFile_(uint64_t start, size_t size, const std::string& spill, const std::string& bloom) {
+  detail::ChunkHeader chunk_header;
+  ring_cache_->Read(start, &chunk_header, sizeof(chunk_header));
+  // 环形 cache 中的 size 只计入环形 cache 中的部分，写入文件的 size 包括溢出部分和过滤器
+  chunk_header.size = size + spill.size() + bloom.size() - sizeof(chunk_header);
+  StringView parts[5];
+  parts[0] = StringView(reinterpret_cast<char*>(&chunk_header), sizeof(chunk_header));
+  ring_cache_->Peek(start + sizeof(chunk_header), size - sizeof(chunk_header), &parts[1], &parts[2]);
+  parts[3] = spill;
+  parts[4] = bloom;
+  WriteToFile_(parts, 5);
   {
-    auto file_path = GetFilePath_();
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    ring_cache_->Consume(size);
+  }
+  flush_cond_.notify_all();
+}
+
+void EffectiveSink::RecoverRing_() {
+  // 已结束的 chunk 在 ChunkHeader 中记录了大小，size 为 0 的是进程退出时尚未结束的 chunk
+  while (!ring_cache_->Empty()) {
+    uint64_t tail = ring_cache_->Tail();
+    size_t remain = ring_cache_->Size();
     detail::ChunkHeader chunk_header;
-    chunk_header.size = slave_cache_->GetSize();
-    memcpy(chunk_header.pub_key, client_pub_key_.data(), client_pub_key_.size());
-    std::ofstream ofs(file_path, std::ios::binary | std::ios::app);
-    ofs.write(reinterpret_cast<char*>(&chunk_header), sizeof(chunk_header));
-    ofs.write(reinterpret_cast<char*>(slave_cache_->Data()), chunk_header.size);
-    ofs.close();
+    if (remain >= sizeof(chunk_header)) {
+      ring_cache_->Read(tail, &chunk_header, sizeof(chunk_header));
+    }
+    if (!detail::ChunkHeader::IsCtr(chunk_header.magic)) {
+      LOG_ERROR("EffectiveSink::RecoverRing_: invalid chunk, size = {}", remain);
+      ring_cache_->Consume(remain);
+      return;
+    }
+    size_t size = remain;
+    if (chunk_header.size != 0) {
+      size = std::min<size_t>(chunk_header.size + sizeof(chunk_header), remain);
+    }
+    RingToFile_(tail, size, std::string(), std::string());
+  }
+}
+
+bool EffectiveSink::WriteToFile_(const StringView* parts, size_t count) {
+  auto file_path = GetFilePath_();
+  if (file_writer_.Path() != file_path || !file_writer_.IsOpen()) {
+    // 按单个文件的大小预分配，之后的写入不再扩展文件区间
+    if (!file_writer_.Open(file_path, space_cast<bytes>(conf_.single_size).count())) {
+      LOG_ERROR("EffectiveSink::WriteToFile_: open file failed, path = {}", file_path.string());
+      return false;
+    }
+  }
+  bool ok = file_writer_.Write(parts, count);
+  if (!ok) {
+    LOG_ERROR("EffectiveSink::WriteToFile_: write file failed, path = {}", file_path.string());
   }
-  slave_cache_->Clear();
-  is_slave_free_.store(true);
+  // 新文件加入索引时保存一次，之后的写入只更新内存中的大小
+  if (file_index_.Touch(file_path, file_writer_.Size())) {
+    file_index_.Save();
+  }
+  return ok;
 }
 
 std::filesystem::path EffectiveSink::GetFilePath_() {
@@ -122,89 +300,566 @@ std::filesystem::path EffectiveSink::GetFilePath_() {
   if (log_file_path_.empty()) {
     log_file_path_ = GetDateTimePath().string() + ".log";
   } else {
-    auto file_size = fs::GetFileSize(log_file_path_);
+    // 当前日志文件的大小由 file_writer_ 记录，不再查询文件系统
+    size_t file_size = file_writer_.Size();
     bytes single_bytes = space_cast<bytes>(conf_.single_size);
     // 若当前日志文件超过限制大小，则重新创建日志文件
     if (file_size > single_bytes.count()) {
       auto date_time_path = GetDateTimePath().string();
       auto file_path = date_time_path + ".log";
       // 若重新创建的日志文件重复，则加上后缀
-      if (std::filesystem::exists(file_path)) {
-        int index = 0;
-        for (auto& p : std::filesystem::directory_iterator(conf_.dir)) {
-          if (p.path().filename().string().find(date_time_path) != std::string::npos) {
-            index++;
-          }
-        }
-        log_file_path_ = date_time_path + "_" + std::to_string(index) + ".log";
-      } else {
-        log_file_path_ = file_path;
+      int index = 0;
+      while (file_index_.Contains(file_path)) {
+        file_path = date_time_path + "_" + std::to_string(++index) + ".log";
       }
+      log_file_path_ = file_path;
     }
   }
   LOG_INFO("EffectiveSink::GetFilePath_: log_file_path={}", log_file_path_.string());
   return log_file_path_;
 }
 
+EffectiveSink::Metrics EffectiveSink::GetMetrics() const {
+  Metrics metrics;
+  metrics.compression_level = metrics_.compression_level.load(std::memory_order_relaxed);
+  metrics.level_changes = metrics_.level_changes.load(std::memory_order_relaxed);
+  metrics.blocks = metrics_.blocks.load(std::memory_order_relaxed);
+  metrics.raw_bytes = metrics_.raw_bytes.load(std::memory_order_relaxed);
+  metrics.compressed_bytes = metrics_.compressed_bytes.load(std::memory_order_relaxed);
+  metrics.compress_ns = metrics_.compress_ns.load(std::memory_order_relaxed);
+  metrics.syncs = metrics_.syncs.load(std::memory_order_relaxed);
+  metrics.sync_ns = metrics_.sync_ns.load(std::memory_order_relaxed);
+  metrics.dropped = metrics_.dropped.load(std::memory_order_relaxed);
+  metrics.flush_waits = metrics_.flush_waits.load(std::memory_order_relaxed);
+  return metrics;
+}
+
 void EffectiveSink::SetFormatter(std::unique_ptr<Formatter> formatter) {
   formatter_ = std::move(formatter);
 }
 
 void EffectiveSink::Flush() {
   TIMER_COUNT("Flush Function");
-  POST_TASK(task_runner_, [this]() { CacheToFile_(); });
+  // 结束 chunk 也放在 task_runner_ 上，与 Drain_ 写主 cache 串行执行
+  POST_TASK(task_runner_, [this]() {
+    Drain_();
+    SealBlock_();
+    CommitBlocks_(0);
+    CloseChunk_();
+    need_new_chunk_ = true;
+  });
   WAIT_TASK_IDLE(task_runner_);
+  // 返回时已结束的 chunk 都已写入文件
+  WAIT_TASK_IDLE(flush_runner_);
+}
 
-  if (is_slave_free_.load()) {
-    is_slave_free_.store(false);
-    SwapCache_();
+SpscRing* EffectiveSink::LocalRing_() {
+  struct LocalRing {
+    std::weak_ptr<bool> alive;  // 所属 sink 的存活标记
+    std::shared_ptr<SpscRing> ring;
+  };
+  struct LocalRings {
+    uint64_t last_id = 0;
+    SpscRing* last = nullptr;
+    std::unordered_map<uint64_t, LocalRing> rings;
+  };
+  static thread_local LocalRings local;
+  if (local.last_id == id_) {
+    return local.last;
+  }
+  // 切换 sink 时顺便清理，否则线程会一直持有已析构的 sink 的暂存缓冲区
+  for (auto it = local.rings.begin(); it != local.rings.end();) {
+    if (it->second.alive.expired()) {
+      it = local.rings.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  auto& entry = local.rings[id_];
+  if (!entry.ring) {
+    entry.alive = alive_;
+    entry.ring = std::make_shared<SpscRing>(space_cast<bytes>(conf_.staging_size).count());
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.push_back(entry.ring);
   }
+  local.last_id = id_;
+  local.last = entry.ring.get();
+  return local.last;
+}
 
-  POST_TASK(task_runner_, [this]() { CacheToFile_(); });
-  WAIT_TASK_IDLE(task_runner_);
+void EffectiveSink::ScheduleDrain_() {
+  if (drain_posted_.load(std::memory_order_relaxed) || drain_posted_.exchange(true)) {
+    return;
+  }
+  POST_TASK(task_runner_, [this]() { Drain_(); });
+}
+
+void EffectiveSink::Drain_() {
+  // 先清除标记再消费，之后写入的日志会重新投递任务，不会遗漏
+  drain_posted_.store(false);
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  // 积压比例作为调整压缩等级的依据之一
+  size_t pending = 0;
+  size_t capacity = 0;
+  for (const auto& ring : rings_) {
+    pending += ring->Size();
+    capacity += ring->Capacity();
+  }
+  backlog_ = capacity == 0 ? 0 : static_cast<double>(pending) / static_cast<double>(capacity);
+  for (auto it = rings_.begin(); it != rings_.end();) {
+    (*it)->Drain([this](const char* data, size_t size) { DrainRecord_(data, size); });
+    // 只剩 rings_ 持有说明生产者线程已经退出
+    if (it->use_count() == 1 && (*it)->Empty()) {
+      it = rings_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void EffectiveSink::Log(const LogMsg& msg) {
+  Stage_(msg);
+  if (conf_.durability == Durability::kOnError && msg.level >= LogLevel::kError) {
+    // 未满的块也立即压缩写入 cache，返回时该日志已经落盘
+    POST_TASK(task_runner_, [this]() {
+      Drain_();
+      SealBlock_();
+      CommitBlocks_(0);
+      SyncCache_(false);
+    });
+    WAIT_TASK_IDLE(task_runner_);
+  }
+}
+
+void EffectiveSink::SyncCache_(bool async) {
+  auto start = std::chrono::steady_clock::now();
+  if (ring_cache_) {
+    ring_cache_->Sync(async);
+  } else {
+    // 已结束但尚未写入文件的 cache 段也需要同步，未修改的页面不会产生 I/O
+    for (auto& segment : segments_) {
+      segment->Sync(async);
+    }
+  }
+  auto cost = std::chrono::steady_clock::now() - start;
+  metrics_.syncs.fetch_add(1, std::memory_order_relaxed);
+  metrics_.sync_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count(),
+                             std::memory_order_relaxed);
+}
+
+void EffectiveSink::Stage_(const LogMsg& msg) {
   static thread_local std::string buf;
-  formatter_->Format(msg, &buf);
-  // 若主 cache 为空，重置压缩缓冲区，只重置一次以增大压缩比
-  if (master_cache_->Empty()) {
-    compress_->ResetStream();
+  // 延迟格式化的日志只拷贝 LogMsg 与序列化后的参数，普通日志拷贝格式化结果
+  detail::DeferredRecord deferred;
+  detail::FormattedRecord formatted;
+  const void* head = &formatted;
+  size_t head_size = sizeof(formatted);
+  StringView body;
+  // 墙上时间在调用线程上换算一次，日志中的时间戳与 chunk 摘要使用同一个值
+  int64_t wall_ms = msg.WallMs();
+  if (msg.IsDeferred()) {
+    deferred.msg = msg;
+    deferred.msg.wall_ms = wall_ms;
+    head = &deferred;
+    head_size = sizeof(deferred);
+    body = msg.deferred.args;
+  } else {
+    formatted.level = msg.level;
+    formatted.site_id = msg.location.site_id;
+    formatted.thread_name_id = msg.thread_name_id;
+    formatted.wall_ms = wall_ms;
+    LogMsg resolved = msg;
+    resolved.wall_ms = wall_ms;
+    buf.clear();
+    formatter_->Format(resolved, &buf);
+    body = buf;
   }
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    compressed_buf_.reserve(compress_->CompressedBound(buf.size()));
-    size_t compressed_size =
-        compress_->Compress(buf.data(), buf.size(), compressed_buf_.data(), compressed_buf_.capacity());
-    if (compressed_size == 0) {
-      LOG_ERROR("EffectiveSink::Log: compress failed");
+  SpscRing* ring = LocalRing_();
+  if (!ring->TryPush(head, head_size, body.data(), body.size())) {
+    if (!ring->Fits(head_size + body.size())) {
+      // 超过暂存缓冲区容量的日志直接交给 task_runner_，先 Drain_ 以保证同一线程的日志顺序
+      std::string record(static_cast<const char*>(head), head_size);
+      record.append(body.data(), body.size());
+      POST_TASK(task_runner_, [&]() {
+        Drain_();
+        DrainRecord_(record.data(), record.size());
+      });
+      WAIT_TASK_IDLE(task_runner_);
       return;
     }
-    // 开始加密
-    encryped_buf_.clear();
-    encryped_buf_.reserve(compressed_size + 16);
-    crypt_->Encrypt(compressed_buf_.data(), compressed_size, encryped_buf_);
-    if (encryped_buf_.empty()) {
-      LOG_ERROR("EffectiveSink::Log: encrypt failed");
+    if (conf_.overflow_policy == OverflowPolicy::kDrop) {
+      metrics_.dropped.fetch_add(1, std::memory_order_relaxed);
+      ScheduleDrain_();
       return;
     }
-    // 将加密后数据写入 cache
-    WriteToCache_(encryped_buf_.data(), encryped_buf_.size());
+    do {
+      ScheduleDrain_();
+      std::this_thread::yield();
+    } while (!ring->TryPush(head, head_size, body.data(), body.size()));
   }
-  // 若主 cache 超过 0.8 则和从 cache 交换，交换后将从 cache 写入文件
-  if (master_cache_->GetRatio() > 0.8) {
-    if (is_slave_free_.load()) {
-      is_slave_free_.store(false);
-      SwapCache_();
+  ScheduleDrain_();
+}
+
+void EffectiveSink::DrainRecord_(const char* data, size_t size) {
+  auto kind = static_cast<detail::StagedKind>(data[0]);
+  if (kind == detail::StagedKind::kFormatted) {
+    detail::FormattedRecord formatted;
+    memcpy(&formatted, data, sizeof(formatted));
+    WriteRecord_(data + sizeof(formatted), size - sizeof(formatted), formatted);
+    return;
+  }
+  // 记录中的 args 指向调用线程的栈，需要指回暂存缓冲区中紧随其后的参数
+  detail::DeferredRecord deferred;
+  memcpy(&deferred, data, sizeof(deferred));
+  LogMsg& msg = deferred.msg;
+  msg.deferred.args = StringView(data + sizeof(deferred), size - sizeof(deferred));
+  message_buf_.clear();
+  FormatDeferred(msg, &message_buf_);
+  msg.message = message_buf_;
+  msg.deferred = DeferredArgs{};
+  record_buf_.clear();
+  formatter_->Format(msg, &record_buf_);
+  detail::FormattedRecord formatted;
+  formatted.level = msg.level;
+  formatted.site_id = msg.location.site_id;
+  formatted.thread_name_id = msg.thread_name_id;
+  formatted.wall_ms = msg.wall_ms;
+  WriteRecord_(record_buf_.data(), record_buf_.size(), formatted);
+}
+
+bool EffectiveSink::MarkDescribed_(std::vector<bool>& described, uint32_t id) {
+  if (id == 0) {
+    return false;
+  }
+  if (id >= described.size()) {
+    described.resize(id + 1, false);
+  }
+  if (described[id]) {
+    return false;
+  }
+  described[id] = true;
+  return true;
+}
+
+void EffectiveSink::WriteRecord_(const char* data, size_t size, const detail::FormattedRecord& record) {
+  // 每个 chunk 独立解码，因此调用点、线程名称信息也需要在新的 chunk 中重新写入
+  if (block_buf_.empty()) {
+    block_begins_chunk_ = need_new_chunk_;
+    need_new_chunk_ = false;
+    if (block_begins_chunk_) {
+      ++chunk_index_;
+      described_sites_.clear();
+      described_names_.clear();
     }
-    POST_TASK(task_runner_, [this]() { CacheToFile_(); });
-    WAIT_TASK_IDLE(task_runner_);
+  }
+  uint32_t site_id = record.site_id;
+  uint32_t thread_name_id = record.thread_name_id;
+  bool new_site = MarkDescribed_(described_sites_, site_id);
+  bool new_name = MarkDescribed_(described_names_, thread_name_id);
+  if (new_site || new_name) {
+    LogMeta meta;
+    if (new_site) {
+      SourceLocation loc = CallSiteRegistry::Instance().Get(site_id);
+      CallSiteInfo* site = meta.add_sites();
+      site->set_id(site_id);
+      site->set_line(loc.line);
+      site->set_file_name(loc.file_name.data(), loc.file_name.size());
+      site->set_func_name(loc.func_name.data(), loc.func_name.size());
+    }
+    if (new_name) {
+      ThreadNameInfo* thread = meta.add_threads();
+      thread->set_id(thread_name_id);
+      StringView name = ThreadNameRegistry::Instance().Get(thread_name_id);
+      thread->set_name(name.data(), name.size());
+    }
+    meta.SerializeToString(&meta_buf_);
+    detail::AppendRecordFrame(&block_buf_, meta_buf_.data(), meta_buf_.size(), true);
+  }
+  detail::AppendRecordFrame(&block_buf_, data, size, false);
+  block_summary_.Add(record.wall_ms, record.level);
+  if (block_buf_.size() >= space_cast<bytes>(conf_.block_size).count()) {
+    SealBlock_();
   }
 }
+
+void EffectiveSink::SealBlock_() {
+  if (block_buf_.empty()) {
+    return;
+  }
+  std::unique_ptr<BlockJob> job;
+  if (idle_jobs_.empty()) {
+    job = std::make_unique<BlockJob>();
+  } else {
+    job = std::move(idle_jobs_.back());
+    idle_jobs_.pop_back();
+  }
+  job->raw.swap(block_buf_);
+  block_buf_.clear();
+  job->summary = block_summary_;
+  block_summary_ = detail::ChunkSummary();
+  if (block_begins_chunk_) {
+    std::string nonce = crypt::AESCtrCrypt::GenerateNonce();
+    memcpy(chunk_nonce_, nonce.data(), sizeof(chunk_nonce_));
+    chunk_block_seq_ = 0;
+  }
+  job->begin_chunk = block_begins_chunk_;
+  job->chunk_index = chunk_index_;
+  job->block_seq = chunk_block_seq_++;
+  memcpy(job->nonce, chunk_nonce_, sizeof(job->nonce));
+  job->level = compress_->GetLevel();
+  job->done = false;
+  BlockJob* pending = job.get();
+  in_flight_.push_back(std::move(job));
+  if (workers_.empty()) {
+    ProcessBlock_(pending, compress_.get(), crypt_.get(), hasher_.get());
+    pending->done = true;
+    CommitBlocks_(0);
+    return;
+  }
+  BlockWorker* worker = &workers_[next_worker_++ % workers_.size()];
+  auto task = [this, worker, pending]() {
+    ProcessBlock_(pending, worker->compress.get(), worker->crypt.get(), worker->hasher.get());
+    {
+      std::lock_guard<std::mutex> lock(blocks_mutex_);
+      pending->done = true;
+    }
+    blocks_cond_.notify_one();
+    POST_TASK(task_runner_, [this]() { CommitBlocks_(SIZE_MAX); });
+  };
+  POST_TASK(worker->runner, std::move(task));
+  // 限制已分配但未写入的块数，工作线程跟不上时由 task_runner_ 等待，积压留在暂存缓冲区中
+  CommitBlocks_(workers_.size() * 2);
+}
+
+void EffectiveSink::ProcessBlock_(BlockJob* job,
+                                  Compression* compress,
+                                  crypt::AESCtrCrypt* crypt,
+                                  crypt::TokenHasher* hasher) {
+  job->output.clear();
+  job->compressed_size = 0;
+  job->tokens.clear();
+  if (hasher) {
+    HashTokens_(job, hasher);
+  }
+  if (compress->GetLevel() != job->level) {
+    compress->SetLevel(job->level);
+  }
+  // 每个块压缩为独立的一帧，解码时不依赖之前的块
+  job->compressed.resize(compress->CompressedBound(job->raw.size()));
+  auto start = LevelController::clock::now();
+  job->compressed_size =
+      compress->CompressBlock(job->raw.data(), job->raw.size(), job->compressed.data(), job->compressed.size());
+  job->compress_time = LevelController::clock::now() - start;
+  if (job->compressed_size == 0) {
+    LOG_ERROR("EffectiveSink::ProcessBlock_: compress failed");
+    return;
+  }
+  // 块的计数器只由 nonce 和 seq 决定，因此各块可以在不同线程上乱序加密，CTR 模式下密文与明文等长
+  crypt->Reset(job->nonce);
+  crypt->Seek(job->block_seq);
+  crypt->Encrypt(job->compressed.data(), job->compressed_size, job->output);
+  if (job->output.empty()) {
+    LOG_ERROR("EffectiveSink::ProcessBlock_: encrypt failed");
+  }
+}
+
+void EffectiveSink::HashTokens_(BlockJob* job, crypt::TokenHasher* hasher) {
+  // 哈希的密钥由 chunk 的 nonce 派生，块在哪个线程上处理都得到相同的结果
+  hasher->Reset(job->nonce);
+  const char* ptr = job->raw.data();
+  const char* end = ptr + job->raw.size();
+  StringView record;
+  bool is_meta = false;
+  while (ptr < end && detail::ReadRecordFrame(ptr, end, &record, &is_meta)) {
+    if (is_meta) {
+      continue;
+    }
+    ForEachToken(EffectiveFormatter::LogInfoOf(record.data(), record.size()), [job, hasher](StringView token) {
+      if (token.size() >= kMinBloomTokenSize) {
+        job->tokens.push_back(hasher->Hash(token.data(), token.size()));
+      }
+    });
+  }
+  std::sort(job->tokens.begin(), job->tokens.end());
+  job->tokens.erase(std::unique(job->tokens.begin(), job->tokens.end()), job->tokens.end());
+}
+
+std::string EffectiveSink::BuildBloom_(std::vector<uint64_t>* tokens, size_t chunk_size) const {
+  if (!conf_.token_bloom) {
+    return std::string();
+  }
+  std::string bits = BuildTokenBloom(tokens, chunk_size / 4);
+  detail::BlockHeader bloom_header;
+  bloom_header.magic = detail::BlockHeader::kBloomMagic;
+  bloom_header.size = static_cast<uint32_t>(bits.size());
+  std::string bloom(reinterpret_cast<const char*>(&bloom_header), sizeof(bloom_header));
+  bloom.append(bits);
+  return bloom;
+}
+
+void EffectiveSink::CommitBlocks_(size_t max_pending) {
+  while (!in_flight_.empty()) {
+    BlockJob* job = in_flight_.front().get();
+    {
+      std::unique_lock<std::mutex> lock(blocks_mutex_);
+      if (!job->done) {
+        if (in_flight_.size() <= max_pending) {
+          return;
+        }
+        blocks_cond_.wait(lock, [job]() { return job->done; });
+      }
+    }
+    CommitBlock_(job);
+    idle_jobs_.push_back(std::move(in_flight_.front()));
+    in_flight_.pop_front();
+  }
+  // 若当前 chunk 已满且其中的块都已写入，则结束该 chunk，交给 flush_runner_ 写入文件
+  if (need_new_chunk_ && block_buf_.empty() && !ChunkEmpty_()) {
+    CloseChunk_();
+  }
+}
+
+void EffectiveSink::CommitBlock_(BlockJob* job) {
+  metrics_.raw_bytes.fetch_add(job->raw.size(), std::memory_order_relaxed);
+  metrics_.compressed_bytes.fetch_add(job->compressed_size, std::memory_order_relaxed);
+  metrics_.compress_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(job->compress_time).count(),
+                                 std::memory_order_relaxed);
+  // 多个工作线程时，以平均到每个线程的压缩耗时衡量压力
+  auto compress_time = job->compress_time / static_cast<int64_t>(std::max<size_t>(workers_.size(), 1));
+  auto now = LevelController::clock::now();
+  if (conf_.adaptive_level && level_controller_.Update(compress_time, backlog_, now)) {
+    compress_->SetLevel(level_controller_.Level());
+    metrics_.compression_level.store(compress_->GetLevel(), std::memory_order_relaxed);
+    metrics_.level_changes.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (job->begin_chunk) {
+    if (!ChunkEmpty_()) {
+      CloseChunk_();
+    }
+    BeginChunk_(job->nonce);
+  }
+  // 摘要先于块写入，进程在两者之间退出时摘要只会多于实际写入的日志
+  UpdateSummary_(job->summary);
+  chunk_tokens_.insert(chunk_tokens_.end(), job->tokens.begin(), job->tokens.end());
+  // 失败的块写为空块，保证之后的块在解码时使用的 seq 与加密时一致
+  WriteToCache_(job->output.data(), job->output.size());
+  metrics_.blocks.fetch_add(1, std::memory_order_relaxed);
+  // 之后的块已经属于新的 chunk 时，不再重复切换
+  if (ChunkFull_() && job->chunk_index == chunk_index_) {
+    need_new_chunk_ = true;
+  }
+}
+
+void EffectiveSink::BeginChunk_(const char* nonce) {
+  struct {
+    detail::ChunkHeader header;
+    detail::ChunkSummary summary;
+  } begin;
+  static_assert(sizeof(begin) == sizeof(detail::ChunkHeader) + sizeof(detail::ChunkSummary), "no padding");
+  begin.header.magic = detail::ChunkHeader::kMagicV4;
+  begin.header.dict_id = dict_id_;
+  memcpy(begin.header.pub_key, client_pub_key_.data(), std::min(client_pub_key_.size(), sizeof(begin.header.pub_key)));
+  memcpy(begin.header.nonce, nonce, sizeof(begin.header.nonce));
+  chunk_summary_ = begin.summary;
+  chunk_tokens_.clear();
+  // 一起写入，环形 cache 中 ChunkSummary 与 ChunkHeader 一样不会溢出到 spill_buf_
+  PushToChunk_(&begin, sizeof(begin));
+}
+
+void EffectiveSink::UpdateSummary_(const detail::ChunkSummary& summary) {
+  chunk_summary_.Merge(summary);
+  if (ring_cache_) {
+    ring_cache_->Write(chunk_start_ + sizeof(detail::ChunkHeader), &chunk_summary_, sizeof(chunk_summary_));
+  } else {
+    memcpy(master_cache_->Data() + sizeof(detail::ChunkHeader), &chunk_summary_, sizeof(chunk_summary_));
+  }
+}
+
+void EffectiveSink::CloseChunk_() {
+  if (ChunkEmpty_()) {
+    return;
+  }
+  if (ring_cache_) {
+    uint64_t start = chunk_start_;
+    size_t size = ring_cache_->Head() - start;
+    // 回填环形 cache 中 ChunkHeader 的 size，进程退出后可以据此划分遗留的 chunk
+    detail::ChunkHeader chunk_header;
+    ring_cache_->Read(start, &chunk_header, sizeof(chunk_header));
+    chunk_header.size = size - sizeof(chunk_header);
+    ring_cache_->Write(start, &chunk_header, sizeof(chunk_header));
+    chunk_start_ = ring_cache_->Head();
+    // 过滤器在 flush_runner_ 上生成，排序、去重不占用 task_runner_
+    auto task = [this, start, size, spill = std::move(spill_buf_), tokens = std::move(chunk_tokens_)]() mutable {
+      RingToFile_(start, size, spill, BuildBloom_(&tokens, size + spill.size()));
+    };
+    spill_buf_.clear();
+    chunk_tokens_.clear();
+    POST_TASK(flush_runner_, std::move(task));
+    return;
+  }
+  MmapAux* sealed = master_cache_;
+  auto task = [this, sealed, tokens = std::move(chunk_tokens_)]() mutable {
+    SegmentToFile_(sealed, BuildBloom_(&tokens, sealed->GetSize()));
+    {
+      std::lock_guard<std::mutex> lock(flush_mutex_);
+      free_segments_.push_back(sealed);
+    }
+    flush_cond_.notify_all();
+  };
+  POST_TASK(flush_runner_, std::move(task));
+  // 只有所有 cache 段都在等待写入文件时才需要等待
+  std::unique_lock<std::mutex> lock(flush_mutex_);
+  if (free_segments_.empty()) {
+    metrics_.flush_waits.fetch_add(1, std::memory_order_relaxed);
+    flush_cond_.wait(lock, [this]() { return !free_segments_.empty(); });
+  }
+  chunk_tokens_.clear();
+  master_cache_ = free_segments_.back();
+  free_segments_.pop_back();
+}
+
 void EffectiveSink::WriteToCache_(const void* data, uint32_t size) {
-  detail::ItemHeader item_header;
-  item_header.size = size;
-  master_cache_->Push(&item_header, sizeof(item_header));
-  master_cache_->Push(data, size);
+  detail::BlockHeader block_header;
+  block_header.size = size;
+  PushToChunk_(&block_header, sizeof(block_header));
+  PushToChunk_(data, size);
+}
+
+void EffectiveSink::PushToChunk_(const void* data, size_t size) {
+  if (!ring_cache_) {
+    master_cache_->Push(data, size);
+    return;
+  }
+  // 一旦溢出，当前 chunk 之后的数据都追加到 spill_buf_，保证顺序
+  if (spill_buf_.empty()) {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    while (!ring_cache_->Push(data, size)) {
+      // 之前的 chunk 都已写入文件仍然放不下，说明当前 chunk 本身超过了容量
+      if (ring_cache_->Tail() == chunk_start_) {
+        lock.unlock();
+        spill_buf_.append(static_cast<const char*>(data), size);
+        return;
+      }
+      metrics_.flush_waits.fetch_add(1, std::memory_order_relaxed);
+      flush_cond_.wait(lock);
+    }
+    return;
+  }
+  spill_buf_.append(static_cast<const char*>(data), size);
+}
+
+bool EffectiveSink::ChunkEmpty_() const {
+  if (ring_cache_) {
+    return ring_cache_->Head() == chunk_start_ && spill_buf_.empty();
+  }
+  return master_cache_->Empty();
+}
+
+bool EffectiveSink::ChunkFull_() const {
+  // 环形 cache 保留一半的容量给已分配但尚未写入的块，正常情况下不会溢出
+  if (ring_cache_) {
+    return ring_cache_->Head() - chunk_start_ + spill_buf_.size() > ring_cache_->Capacity() / 2;
+  }
+  return master_cache_->GetRatio() > 0.8;
 }
 }  // namespace logger
\ No newline at end of file
@@ -1,44 +1,196 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "compress.h"
-#include "crypt.h"
+#include "aes_crypt.h"
+#include "token_hasher.h"
 #include "executor.h"
+#include "file_writer.h"
 #include "formatter.h"
+#include "level_controller.h"
+#include "log_file_index.h"
 #include "mmap_aux.h"
+#include "mmap_ring.h"
 #include "sink.h"
 #include "space.h"
+#include "spsc_ring.h"
 
 namespace logger {
 
 namespace detail {
+// 单行 mmap 的 header，仅用于 v1 格式
+struct ItemHeader {
+  static constexpr uint32_t kMagic = 0xbe5fba11;
+  static constexpr uint32_t kMetaMagic = 0xbe5fba12;  // 数据为 LogMeta(调用点信息)
+  uint32_t magic;
+  uint32_t size;
+
+  ItemHeader() : magic(kMagic), size(0) {}
+};
+
+// v2 格式中压缩块的 header，之后为加密后的压缩块
+// 块解压后为若干条记录，每条记录为 varint(size << 1 | is_meta) + 数据，is_meta 为 1 时数据为 LogMeta
+struct BlockHeader {
+  static constexpr uint32_t kMagic = 0xb10cda7a;
+  static constexpr uint32_t kBloomMagic = 0xb100f17e;  // chunk 的最后一项，之后为明文的词 Bloom 过滤器
+  uint32_t magic;
+  uint32_t size;
+
+  BlockHeader() : magic(kMagic), size(0) {}
+};
+
 // mmap 块的 header
 struct ChunkHeader {
-  static constexpr uint64_t kMagic = 0xdeadbeefdada1100;
+  static constexpr uint64_t kMagic = 0xdeadbeefdada1100;    // v1: 每条日志单独压缩、加密，以 ItemHeader 分隔
+  static constexpr uint64_t kMagicV2 = 0xdeadbeefdada1200;  // v2: 多条日志组成一个块，以 BlockHeader 分隔
+  static constexpr uint64_t kMagicV3 = 0xdeadbeefdada1300;  // v3: 同 v2，块使用 AES-CTR 加密，计数器由 nonce 生成
+  static constexpr uint64_t kMagicV4 = 0xdeadbeefdada1400;  // v4: 同 v3，ChunkHeader 之后为明文的 ChunkSummary
+  static constexpr size_t kNonceSize = crypt::AESCtrCrypt::kNonceSize;
+  static constexpr size_t kPubKeySize = 65;  // secp256r1 未压缩公钥(0x04 + X + Y)的长度
   uint64_t magic;
   uint64_t size;
-  char pub_key[128];
+  char pub_key[116];       // 客户端公钥，二进制数据，前 kPubKeySize 字节有效
+  uint32_t dict_id;        // v3 及之后使用，块压缩使用的 zstd 字典 id，0 表示不使用字典
+  char nonce[kNonceSize];  // v3 及之后使用
+
+  ChunkHeader() : magic(kMagic), size(0), pub_key{0}, dict_id(0), nonce{0} {}
 
-  ChunkHeader() : magic(kMagic), size(0) {}
+  /// @brief 根据 cache 中第一个 header 判断数据格式，兼容升级前遗留的 v1 cache
+  /// @param data
+  /// @param size
+  /// @return
+  static uint64_t MagicOf(const void* data, size_t size) {
+    uint32_t magic = 0;
+    if (size >= sizeof(magic)) {
+      memcpy(&magic, data, sizeof(magic));
+    }
+    return magic == ItemHeader::kMagic || magic == ItemHeader::kMetaMagic ? kMagic : kMagicV2;
+  }
+
+  /// @brief v3 及之后的 chunk 在 cache 中以 ChunkHeader 开头，块使用 AES-CTR 加密
+  /// @param magic
+  /// @return
+  static bool IsCtr(uint64_t magic) { return magic == kMagicV3 || magic == kMagicV4; }
 };
+static_assert(sizeof(ChunkHeader) == 144, "ChunkHeader layout is shared by all versions");
 
-// 单行 mmap 的 header
-struct ItemHeader {
-  static constexpr uint32_t kMagic = 0xbe5fba11;
-  uint32_t magic;
-  uint32_t size;
+/// @brief v4 chunk 中日志的时间范围与等级，不加密，解码时据此跳过不需要的 chunk
+/// ChunkHeader 中的 size 包括该结构，写入块之前先更新，遗留的 cache 中的摘要不会遗漏已写入的日志
+struct ChunkSummary {
+  int64_t min_timestamp;  // 最早的日志时间，毫秒
+  int64_t max_timestamp;  // 最晚的日志时间，毫秒
+  uint32_t count;         // 日志条数
+  uint32_t levels;        // 出现过的日志等级，第 level 位为 1
 
-  ItemHeader() : magic(kMagic), size(0) {}
+  ChunkSummary() : min_timestamp(INT64_MAX), max_timestamp(INT64_MIN), count(0), levels(0) {}
+
+  void Add(int64_t timestamp, LogLevel level) {
+    min_timestamp = std::min(min_timestamp, timestamp);
+    max_timestamp = std::max(max_timestamp, timestamp);
+    ++count;
+    levels |= 1u << static_cast<uint32_t>(level);
+  }
+
+  void Merge(const ChunkSummary& other) {
+    min_timestamp = std::min(min_timestamp, other.min_timestamp);
+    max_timestamp = std::max(max_timestamp, other.max_timestamp);
+    count += other.count;
+    levels |= other.levels;
+  }
 };
+static_assert(sizeof(ChunkSummary) == 24, "ChunkSummary is written to file as is");
+
+/// @brief 向块中追加一条记录
+/// @param dest
+/// @param data
+/// @param size
+/// @param is_meta
+inline void AppendRecordFrame(std::string* dest, const char* data, size_t size, bool is_meta) {
+  uint64_t value = (static_cast<uint64_t>(size) << 1) | (is_meta ? 1 : 0);
+  while (value >= 0x80) {
+    dest->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  dest->push_back(static_cast<char>(value));
+  dest->append(data, size);
+}
+
+/// @brief 从块中读取一条记录，ptr 移动到下一条记录
+/// @param ptr
+/// @param end
+/// @param record
+/// @param is_meta
+/// @return 数据不完整时返回 false
+inline bool ReadRecordFrame(const char*& ptr, const char* end, StringView* record, bool* is_meta) {
+  uint64_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    if (ptr == end || shift > 63) {
+      return false;
+    }
+    auto byte = static_cast<uint8_t>(*ptr++);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      break;
+    }
+  }
+  uint64_t size = value >> 1;
+  if (size > static_cast<uint64_t>(end - ptr)) {
+    return false;
+  }
+  *record = StringView(ptr, size);
+  *is_meta = (value & 1) != 0;
+  ptr += size;
+  return true;
+}
+
+// 暂存缓冲区中记录的类型，位于每条记录的第一个字节
+enum class StagedKind : uint8_t {
+  kFormatted = 1,  // 之后为格式化后的日志
+  kDeferred = 2,   // 之后为 LogMsg 以及序列化后的参数，由 task_runner_ 格式化
+};
+
+struct FormattedRecord {
+  StagedKind kind = StagedKind::kFormatted;
+  LogLevel level = LogLevel::kInfo;
+  uint32_t site_id = 0;
+  uint32_t thread_name_id = 0;
+  int64_t wall_ms = 0;  // 暂存时换算的墙上时间，与写入日志的时间戳相同，用于 chunk 摘要
+};
+
+struct DeferredRecord {
+  StagedKind kind = StagedKind::kDeferred;
+  LogMsg msg;
+};
+static_assert(std::is_trivially_copyable_v<DeferredRecord>, "DeferredRecord is copied into SpscRing by memcpy");
 
 }  // namespace detail
 
 class EffectiveSink final : public LogSink {
  public:
+  /// @brief cache 的持久化策略，级别越高断电时丢失的日志越少，写入延迟越高
+  /// 只作用于 mmap cache，尚未压缩的块以及已写入日志文件的数据不受影响
+  enum class Durability {
+    kNone,      // 由内核决定何时回写
+    kPeriodic,  // 每隔 sync_interval 以 MS_ASYNC 发起回写
+    kOnError,   // 同 kPeriodic，另外 error 及以上等级的日志在返回前写入 cache 并以 MS_SYNC 同步
+  };
+
+  /// @brief 生产者线程的暂存缓冲区已满时的处理方式，通常发生在所有 cache 段都在等待写入文件时
+  enum class OverflowPolicy {
+    kBlock,  // 等待 task_runner_ 取走数据
+    kDrop,   // 丢弃该条日志并计数，生产者线程不等待
+  };
+
   /// @brief 存储日志文件相关的信息
   struct Conf {
     std::filesystem::path dir;  // 日志保存目录
@@ -47,60 +199,296 @@ class EffectiveSink final : public LogSink {
     std::chrono::minutes interval{5};  // 文件存活时间
     megabytes single_size{4};          // 单个文件大小
     megabytes total_size{100};         // 总文件大小
+    bool save_index{false};            // 将日志文件索引保存为 {prefix}.index，启动时不再遍历目录
+    kilobytes staging_size{256};       // 每个生产者线程的暂存环形缓冲区大小，位于堆内存，崩溃时其中的日志丢失
+    kilobytes block_size{64};          // 累积到该大小后压缩、加密为一个块，写入 cache 前位于堆内存，崩溃时丢失
+    std::filesystem::path dict_path;   // 可选，train_dict 生成的 zstd 字典，解码时需要提供同一字典
+    int compression_level{5};          // 压缩等级，开启 adaptive_level 时为空闲时的等级
+    bool adaptive_level{true};         // 根据积压和压缩耗时自动调整压缩等级
+    int min_compression_level{-5};     // 自动调整时的最低等级
+    double compress_cpu_budget{0.5};   // 压缩耗时占写入线程时间的上限，超过则降低等级
+    size_t compress_workers{0};        // 并行压缩、加密块的工作线程数，0 表示在 task_runner_ 上完成
+    bool ring_cache{false};            // 使用固定容量的环形 mmap 代替主从 cache，写入时不会重新映射
+    size_t cache_segments{2};          // 主从 cache 模式下的 cache 段数，至少为 2
+    kilobytes ring_size{1024};         // 环形 cache 的容量，chunk 超过一半容量时写入文件
+    bool prefault_cache{true};         // 创建环形 cache 时预先载入全部页面
+    Durability durability{Durability::kNone};
+    std::chrono::milliseconds sync_interval{1000};  // kPeriodic、kOnError 时定期回写的间隔
+    std::chrono::milliseconds seal_interval{200};   // 未满的块最多等待该时间即写入 cache，0 表示只在块满或 Flush 时写入
+    OverflowPolicy overflow_policy{OverflowPolicy::kBlock};
+    bool token_bloom{false};  // 为每个 chunk 的日志内容建立带密钥的词 Bloom 过滤器，解码时 --grep 据此跳过 chunk
+  };
+
+  /// @brief 运行指标的快照
+  struct Metrics {
+    int compression_level = 0;      // 当前压缩等级
+    uint64_t level_changes = 0;     // 压缩等级调整次数
+    uint64_t blocks = 0;            // 已写入 cache 的块数
+    uint64_t raw_bytes = 0;         // 压缩前的字节数
+    uint64_t compressed_bytes = 0;  // 压缩后的字节数
+    uint64_t compress_ns = 0;       // 压缩累计耗时
+    uint64_t syncs = 0;             // msync 次数
+    uint64_t sync_ns = 0;           // msync 累计耗时
+    uint64_t dropped = 0;           // kDrop 策略下丢弃的日志条数
+    uint64_t flush_waits = 0;       // 没有空闲的 cache 段或环形 cache 空间、等待写入文件的次数
   };
 
   /// @brief 构造函数，主要完成如下功能：
   /// 1. 初始化 running_tag，此后当前日志文件的操作都在该线程下完成；
   /// 2. 获取 ECDH 私钥、公钥，使用生成的私钥和提供的 server_pub 生成 AES 密钥；
   /// 3. 创建加密对象、压缩对象；
-  /// 4. 创建主从 mmap；
-  /// 5. 保证主从 mmap 为空；
+  /// 4. 创建 cache 段或环形 cache；
+  /// 5. 将遗留的 cache 写入文件，保证 cache 为空；
   /// @param conf
   explicit EffectiveSink(Conf conf);
-  ~EffectiveSink() = default;
+
+  /// @brief 将各线程暂存缓冲区中剩余的日志写入主 cache
+  ~EffectiveSink();
 
   void Log(const LogMsg& msg) override;
   void SetFormatter(std::unique_ptr<Formatter> formatter) override;
   void Flush() override;
+  bool AcceptDeferred() const override { return true; }
+
+  /// @brief 可在任意线程调用
+  /// @return
+  Metrics GetMetrics() const;
 
  private:
-  /// @brief 将从 cache 中的内容写入文件
-  void CacheToFile_();
+  /// @brief 第 index 个 cache 段的文件路径，前两段沿用主从 cache 的文件名
+  /// @param index
+  /// @return
+  std::filesystem::path SegmentPath_(size_t index) const;
+
+  /// @brief 将 cache 段中的 chunk 写入文件并清空，在 flush_runner_ 上调用
+  /// @param segment
+  /// @param bloom 追加在 chunk 末尾的过滤器，遗留的 cache 没有过滤器
+  void SegmentToFile_(MmapAux* segment, const std::string& bloom);
+
+  /// @brief 将环形 cache 中已结束的 chunk 以及溢出部分写入文件并释放空间，在 flush_runner_ 上调用
+  /// @param start chunk 在环形 cache 中的起始位置
+  /// @param size chunk 在环形 cache 中的大小
+  /// @param spill
+  /// @param bloom 追加在 chunk 末尾的过滤器
+  void RingToFile_(uint64_t start, size_t size, const std::string& spill, const std::string& bloom);
+
+  /// @brief 将环形 cache 中遗留的 chunk 依次写入文件，未结束的 chunk 包含之后的全部数据
+  void RecoverRing_();
 
   /// @brief 获取日志文件名称
   std::filesystem::path GetFilePath_();
 
-  void SwapCache_() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::swap(master_cache_, slave_cache_);
-  }
+  /// @brief 将多段数据写入当前日志文件，必要时切换到新的日志文件
+  /// @param parts
+  /// @param count
+  /// @return
+  bool WriteToFile_(const StringView* parts, size_t count);
 
-  /// @brief 当日志文件总大小大于限制值，则删除超时文件
+  /// @brief 当日志文件总大小大于限制值，则从最旧的文件开始删除，只查询 file_index_
   void ElimateFiles_();
 
-  /// @brief 将内存中的数据 data 写入主 cache 中
+  /// @brief 获取当前线程在本 sink 上的暂存缓冲区，首次调用时创建并注册
+  /// 同时释放当前线程在已析构的 sink 上的暂存缓冲区
+  /// @return
+  SpscRing* LocalRing_();
+
+  /// @brief 将日志拷贝到当前线程的暂存缓冲区
+  /// @param msg
+  void Stage_(const LogMsg& msg);
+
+  /// @brief 以 msync 同步当前 cache，必须在 task_runner_ 上调用
+  /// @param async
+  void SyncCache_(bool async);
+
+  /// @brief 若当前没有待执行的 Drain_ 任务，则向 task_runner_ 投递一个
+  void ScheduleDrain_();
+
+  /// @brief 在 task_runner_ 上运行，批量取出各线程暂存的日志写入主 cache
+  void Drain_();
+
+  /// @brief 处理暂存缓冲区中的一条记录，延迟格式化的记录在此完成格式化
+  /// @param data
+  /// @param size
+  void DrainRecord_(const char* data, size_t size);
+
+  /// @brief 将一条格式化后的日志追加到当前块，必须在 task_runner_ 上调用
+  /// 若日志引用的调用点或线程名称尚未在当前 chunk 中出现，先追加对应的信息
+  /// @param data
+  /// @param size
+  /// @param record 日志的等级、时间、调用点和线程名称
+  void WriteRecord_(const char* data, size_t size, const detail::FormattedRecord& record);
+
+  /// @brief 标记 id 已在当前 chunk 中出现
+  /// @param described
+  /// @param id
+  /// @return id 是否首次出现
+  static bool MarkDescribed_(std::vector<bool>& described, uint32_t id);
+
+  /// @brief 一个待压缩、加密的块，由 task_runner_ 确定所属 chunk 与序号，处理完成后按分配顺序写入主 cache
+  struct BlockJob {
+    std::string raw;                                    // 块中的记录
+    std::string compressed;                             // 压缩数据存放缓存
+    std::string output;                                 // 压缩、加密后的数据，失败时为空
+    detail::ChunkSummary summary;                       // 块中日志的时间范围与等级
+    std::vector<uint64_t> tokens;                       // 块中日志内容的词哈希，已去重，未开启 token_bloom 时为空
+    int level = 0;                                      // 压缩等级
+    bool begin_chunk = false;                           // 是否为新 chunk 的第一个块
+    uint64_t chunk_index = 0;                           // 所属 chunk 的编号
+    uint32_t block_seq = 0;                             // 块在 chunk 中的序号，即 CTR 的 seq
+    char nonce[crypt::AESCtrCrypt::kNonceSize] = {0};  // 所属 chunk 的 nonce
+    size_t compressed_size = 0;
+    LevelController::clock::duration compress_time{};
+    bool done = false;  // 由 blocks_mutex_ 保护
+  };
+
+  /// @brief 工作线程各自持有压缩、加密对象，互不共享状态
+  struct BlockWorker {
+    TaskRunnerTag runner;
+    std::unique_ptr<Compression> compress;
+    std::unique_ptr<crypt::AESCtrCrypt> crypt;
+    std::unique_ptr<crypt::TokenHasher> hasher;  // 未开启 token_bloom 时为空
+  };
+
+  /// @brief 为当前块分配 chunk 与序号，交给工作线程或直接在 task_runner_ 上压缩、加密
+  void SealBlock_();
+
+  /// @brief 压缩、加密一个块，可在任意线程调用
+  /// @param job
+  /// @param compress
+  /// @param crypt
+  /// @param hasher 不为空时同时计算块中的词哈希
+  static void ProcessBlock_(BlockJob* job,
+                            Compression* compress,
+                            crypt::AESCtrCrypt* crypt,
+                            crypt::TokenHasher* hasher);
+
+  /// @brief 以块中日志内容的词计算哈希，结果排序去重后存入 job->tokens
+  /// @param job
+  /// @param hasher
+  static void HashTokens_(BlockJob* job, crypt::TokenHasher* hasher);
+
+  /// @brief 由 chunk 的词哈希生成以 BlockHeader::kBloomMagic 开头的过滤器，未开启 token_bloom 时为空
+  /// @param tokens
+  /// @param chunk_size 过滤器不超过 chunk 大小的 1/4
+  /// @return
+  std::string BuildBloom_(std::vector<uint64_t>* tokens, size_t chunk_size) const;
+
+  /// @brief 按分配顺序将已完成的块写入主 cache，必须在 task_runner_ 上调用
+  /// @param max_pending 未完成的块多于该数量时等待，0 表示等待全部完成
+  void CommitBlocks_(size_t max_pending);
+
+  /// @brief 将一个已完成的块写入主 cache，必要时先结束上一个 chunk
+  /// @param job
+  void CommitBlock_(BlockJob* job);
+
+  /// @brief 在主 cache 起始位置写入 ChunkHeader 与空的 ChunkSummary
+  /// ChunkHeader 中的 size 在写入文件时更新，遗留的 cache 也可以独立解码
+  /// @param nonce 该 chunk 的 nonce
+  void BeginChunk_(const char* nonce);
+
+  /// @brief 将块的摘要合并到当前 chunk，并更新 cache 中的 ChunkSummary
+  /// @param summary
+  void UpdateSummary_(const detail::ChunkSummary& summary);
+
+  /// @brief 结束当前 chunk 并交给 flush_runner_ 写入文件，主从 cache 模式下切换到空闲的 cache 段
+  /// 没有空闲的 cache 段时等待，不会等待文件写入本身
+  void CloseChunk_();
+
+  /// @brief 将加密后的块以 BlockHeader 写入当前 chunk
   /// @param data
   /// @param size
   void WriteToCache_(const void* data, uint32_t size);
 
+  /// @brief 向当前 chunk 追加数据，环形 cache 空间被之前的 chunk 占用时等待写入文件，
+  /// 当前 chunk 本身超过容量时追加到 spill_buf_
+  /// @param data
+  /// @param size
+  void PushToChunk_(const void* data, size_t size);
+
+  /// @brief 当前 chunk 是否为空
+  bool ChunkEmpty_() const;
+
+  /// @brief 当前 chunk 是否已经足够大，之后的块应属于新的 chunk
+  bool ChunkFull_() const;
+
  private:
   Conf conf_;
-  std::unique_ptr<Formatter> formatter_;   // 格式化日志信息
-  std::unique_ptr<crypt::Crypt> crypt_;    // 用于日志加密
-  std::unique_ptr<Compression> compress_;  // 用于日志压缩
-  std::unique_ptr<MmapAux> master_cache_;  // 主 cache
-  std::unique_ptr<MmapAux> slave_cache_;   // 从 cache
-  std::filesystem::path log_file_path_;    // 日志保存路径
+  std::unique_ptr<Formatter> formatter_;            // 格式化日志信息
+  std::unique_ptr<crypt::AESCtrCrypt> crypt_;       // 用于日志加密，未启用工作线程时使用
+  std::unique_ptr<crypt::TokenHasher> hasher_;      // 开启 token_bloom 且未启用工作线程时使用
+  std::unique_ptr<Compression> compress_;           // 用于日志压缩，未启用工作线程时使用，其等级为当前等级
+  std::vector<std::unique_ptr<MmapAux>> segments_;  // 主从 cache 模式下的全部 cache 段
+  MmapAux* master_cache_{nullptr};                  // 当前写入的 cache 段
+  std::unique_ptr<MmapRing> ring_cache_;            // 环形 cache，不为空时代替主从 cache
+  uint64_t chunk_start_{0};                         // 当前 chunk 在环形 cache 中的起始位置
+  std::string spill_buf_;                           // 当前 chunk 中超出环形 cache 容量的部分
+  std::filesystem::path log_file_path_;             // 日志保存路径，只由 flush_runner_ 访问
+  fs::FileWriter file_writer_;                      // 保持当前日志文件打开
+  fs::LogFileIndex file_index_;                     // 日志目录中的日志文件，只由 flush_runner_ 访问
 
   std::string client_pub_key_;
+  uint32_t dict_id_{0};  // 当前使用的字典 id
 
-  std::string compressed_buf_;  // 压缩数据存放缓存
-  std::string encryped_buf_;    // 加密数据存放缓存
+  std::string block_buf_;               // 当前块中尚未压缩的记录
+  std::string message_buf_;             // 延迟格式化的日志内容
+  std::string record_buf_;              // 延迟格式化后经 formatter_ 处理的日志
+  std::string meta_buf_;                // 序列化后的调用点信息
+  std::vector<bool> described_sites_;   // 当前 chunk 中已写入信息的调用点
+  std::vector<bool> described_names_;   // 当前 chunk 中已写入的线程名称
+  detail::ChunkSummary block_summary_;  // 当前块中日志的时间范围与等级
+  detail::ChunkSummary chunk_summary_;  // 已写入主 cache 的块的摘要，只由 task_runner_ 访问
+  std::vector<uint64_t> chunk_tokens_;  // 已写入主 cache 的块的词哈希，结束 chunk 时交给 flush_runner_
+
+  // chunk 的划分在块开始时确定，工作线程乱序完成也不影响块所属的 chunk 和 seq
+  bool need_new_chunk_{true};       // 下一个块是否开始新的 chunk
+  bool block_begins_chunk_{false};  // 当前块是否为新 chunk 的第一个块
+  uint64_t chunk_index_{0};         // 当前块所属 chunk 的编号
+  char chunk_nonce_[crypt::AESCtrCrypt::kNonceSize] = {0};
+  uint32_t chunk_block_seq_{0};  // 当前 chunk 中下一个块的序号
+
+  // 已分配但尚未写入主 cache 的块，按分配顺序排列，只由 task_runner_ 访问
+  std::vector<BlockWorker> workers_;
+  size_t next_worker_{0};
+  std::deque<std::unique_ptr<BlockJob>> in_flight_;
+  std::vector<std::unique_ptr<BlockJob>> idle_jobs_;  // 复用块的缓存
+  std::mutex blocks_mutex_;
+  std::condition_variable blocks_cond_;
 
   // 同步机制
-  std::mutex mutex_;
   TaskRunnerTag task_runner_;
+  TaskRunnerTag flush_runner_;  // 按顺序将已结束的 chunk 写入文件，并负责日志文件的轮转和淘汰
+
+  // 空闲的 cache 段以及环形 cache 的 head、tail 由 flush_runner_ 释放，task_runner_ 在此等待
+  std::vector<MmapAux*> free_segments_;
+  std::mutex flush_mutex_;
+  std::condition_variable flush_cond_;
+
+  RepeatedTaskId elimate_task_id_{0};  // 定期淘汰过期日志文件的任务
+  RepeatedTaskId sync_task_id_{0};     // 定期回写的任务，durability 为 kNone 时未启用
+  RepeatedTaskId seal_task_id_{0};     // 定期写入未满块的任务，seal_interval 为 0 时未启用
+
+  // 生产者线程只向各自的暂存缓冲区拷贝数据，由 task_runner_ 统一消费
+  uint64_t id_;  // 区分不同 sink 实例的线程局部缓冲区
+  // 线程局部缓冲区以 weak_ptr 引用，sink 析构后各线程据此释放其暂存缓冲区
+  std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<SpscRing>> rings_;
+  std::atomic<bool> drain_posted_{false};
 
-  std::atomic<bool> is_slave_free_{true};  // 从 cache 是否为空
+  // 压缩等级由 task_runner_ 调整，指标供其他线程读取
+  LevelController level_controller_;
+  double backlog_{0};  // 最近一次 Drain_ 开始时暂存缓冲区的积压比例
+  struct {
+    std::atomic<int> compression_level{0};
+    std::atomic<uint64_t> level_changes{0};
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> raw_bytes{0};
+    std::atomic<uint64_t> compressed_bytes{0};
+    std::atomic<uint64_t> compress_ns{0};
+    std::atomic<uint64_t> syncs{0};
+    std::atomic<uint64_t> sync_ns{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> flush_waits{0};
+  } metrics_;
 };
 }  // namespace logger
\ No newline at end of file
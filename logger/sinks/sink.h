@@ -13,5 +13,8 @@ namespace logger {
       virtual void SetFormatter(std::unique_ptr<Formatter> formatter) = 0;
 
       virtual void Flush() {}
+
+      /// @brief 是否可以直接接收未格式化(LogMsg::IsDeferred)的日志
+      virtual bool AcceptDeferred() const { return false; }
   };
 }
\ No newline at end of file
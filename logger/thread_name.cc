@@ -0,0 +1,37 @@
+#include "thread_name.h"
+
+namespace logger {
+ThreadNameRegistry& ThreadNameRegistry::Instance() {
+  static ThreadNameRegistry instance;
+  return instance;
+}
+
+uint32_t ThreadNameRegistry::Register(const std::string& name) {
+  std::string key = name.substr(0, kMaxNameLength);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(key);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  names_.push_back(key);
+  uint32_t id = static_cast<uint32_t>(names_.size());
+  ids_.emplace(std::move(key), id);
+  return id;
+}
+
+StringView ThreadNameRegistry::Get(uint32_t id) const {
+  if (id == 0) {
+    return StringView();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id > names_.size()) {
+    return StringView();
+  }
+  return names_[id - 1];
+}
+
+void SetThreadName(const std::string& name) {
+  detail::thread_name_id = name.empty() ? 0 : ThreadNameRegistry::Instance().Register(name);
+  detail::thread_name = ThreadNameRegistry::Instance().Get(detail::thread_name_id);
+}
+}  // namespace logger
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "log_common.h"
+
+namespace logger {
+/// @brief 线程名称注册表：线程名称只注册一次，日志只携带名称 id，
+/// 名称本身由 sink 在 cache 中单独记录一次
+class ThreadNameRegistry {
+ public:
+  // 名称过长会被截断
+  static constexpr size_t kMaxNameLength = 32;
+
+  ThreadNameRegistry(const ThreadNameRegistry&) = delete;
+  ThreadNameRegistry& operator=(const ThreadNameRegistry&) = delete;
+
+  static ThreadNameRegistry& Instance();
+
+  /// @brief 注册线程名称，相同名称返回相同 id
+  /// @param name
+  /// @return 名称 id，从 1 开始
+  uint32_t Register(const std::string& name);
+
+  /// @brief 获取名称，id 不存在时返回空字符串，已注册的名称不会释放
+  /// @param id
+  /// @return
+  StringView Get(uint32_t id) const;
+
+ private:
+  ThreadNameRegistry() = default;
+
+ private:
+  mutable std::mutex mutex_;
+  std::deque<std::string> names_;  // push_back 不会使已有元素失效
+  std::unordered_map<std::string, uint32_t> ids_;
+};
+
+namespace detail {
+inline thread_local uint32_t thread_name_id = 0;
+inline thread_local StringView thread_name;  // thread_name_id 对应的名称，指向注册表中不会释放的字符串
+}  // namespace detail
+
+/// @brief 设置当前线程的名称，之后该线程产生的日志都会携带名称 id
+/// @param name
+void SetThreadName(const std::string& name);
+
+/// @brief 当前线程的名称 id，未设置时为 0
+/// @return
+inline uint32_t GetThreadNameId() {
+  return detail::thread_name_id;
+}
+
+/// @brief 获取名称 id 对应的名称，为当前线程的名称时直接返回缓存，不访问注册表
+/// @param id
+/// @return
+inline StringView GetThreadName(uint32_t id) {
+  if (id == detail::thread_name_id) {
+    return detail::thread_name;
+  }
+  return ThreadNameRegistry::Instance().Get(id);
+}
+}  // namespace logger
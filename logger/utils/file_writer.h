@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+
+#include "log_common.h"
+
+namespace logger {
+namespace fs {
+/// @brief 保持当前日志文件的 fd 打开，按内存中记录的偏移写入，避免每次写入都打开、关闭文件
+/// 创建文件时预分配空间但不改变文件大小，文件大小始终为已写入的数据量
+class FileWriter {
+ public:
+  FileWriter() = default;
+  ~FileWriter();
+
+  FileWriter(const FileWriter&) = delete;
+  FileWriter& operator=(const FileWriter&) = delete;
+
+  /// @brief 打开文件并从末尾开始写入，已打开的文件会先关闭
+  /// @param file_path
+  /// @param preallocate 预分配的字节数，0 表示不预分配
+  /// @return
+  bool Open(const std::filesystem::path& file_path, size_t preallocate);
+
+  /// @brief 关闭文件，释放超出已写入数据的预分配空间
+  void Close();
+
+  bool IsOpen() const noexcept { return fd_ != -1; }
+
+  const std::filesystem::path& Path() const noexcept { return file_path_; }
+
+  /// @brief 已写入的数据量，即下一次写入的偏移
+  /// @return
+  size_t Size() const noexcept { return offset_; }
+
+  /// @brief 将多段数据依次写入文件末尾，合并为一次系统调用
+  /// @param parts
+  /// @param count
+  /// @return 失败时返回 false，此时已写入的部分不计入 Size()
+  bool Write(const StringView* parts, size_t count);
+
+ private:
+  std::filesystem::path file_path_;
+  int fd_ = -1;
+  size_t offset_ = 0;
+};
+}  // namespace fs
+}  // namespace logger
@@ -0,0 +1,98 @@
+#include "file_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "internal_log.h"
+
+namespace logger {
+namespace fs {
+// 单次 Write 最多合并的数据段数
+static constexpr size_t kMaxParts = 8;
+
+FileWriter::~FileWriter() {
+  Close();
+}
+
+bool FileWriter::Open(const std::filesystem::path& file_path, size_t preallocate) {
+  Close();
+  // 不使用 O_APPEND，否则 pwritev 会忽略指定的偏移
+  int fd = open(file_path.string().c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  // FALLOC_FL_KEEP_SIZE 只分配空间，不改变文件大小，文件系统不支持时忽略，其他错误只影响性能
+  if (preallocate > size &&
+      fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(size), static_cast<off_t>(preallocate - size)) != 0 &&
+      errno != EOPNOTSUPP) {
+    LOG_ERROR("FileWriter::Open: fallocate failed, path = {}, error = {}", file_path.string(), strerror(errno));
+  }
+  fd_ = fd;
+  file_path_ = file_path;
+  offset_ = size;
+  return true;
+}
+
+void FileWriter::Close() {
+  if (fd_ == -1) {
+    return;
+  }
+  // 截断到当前大小，释放未使用的预分配空间
+  if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+    LOG_ERROR("FileWriter::Close: ftruncate failed, path = {}, error = {}", file_path_.string(), strerror(errno));
+  }
+  close(fd_);
+  fd_ = -1;
+  offset_ = 0;
+}
+
+bool FileWriter::Write(const StringView* parts, size_t count) {
+  if (fd_ == -1 || count > kMaxParts) {
+    return false;
+  }
+  iovec iov[kMaxParts];
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    iov[i].iov_base = const_cast<char*>(parts[i].data());
+    iov[i].iov_len = parts[i].size();
+    total += parts[i].size();
+  }
+  iovec* cur = iov;
+  int remaining = static_cast<int>(count);
+  size_t written = 0;
+  while (written < total) {
+    ssize_t ret = pwritev(fd_, cur, remaining, static_cast<off_t>(offset_ + written));
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+    written += static_cast<size_t>(ret);
+    // 部分写入时跳过已写完的数据段
+    size_t done = static_cast<size_t>(ret);
+    while (remaining > 0 && done >= cur->iov_len) {
+      done -= cur->iov_len;
+      ++cur;
+      --remaining;
+    }
+    if (remaining > 0) {
+      cur->iov_base = static_cast<char*>(cur->iov_base) + done;
+      cur->iov_len -= done;
+    }
+  }
+  offset_ += total;
+  return true;
+}
+}  // namespace fs
+}  // namespace logger
@@ -0,0 +1,2 @@
+// Windows 上的接口实现
+#include "file_writer.h"
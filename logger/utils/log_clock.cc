@@ -0,0 +1,107 @@
+#include "log_clock.h"
+
+#ifdef LOGGER_CLOCK_USE_TSC
+#if !defined(_M_X64)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace logger {
+namespace {
+int64_t MonotonicNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t RealtimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/// @brief 测量每个原始计数对应的纳秒数，进程内只测量一次
+double MeasureNsPerTick() {
+#ifdef LOGGER_CLOCK_USE_TSC
+  if (!LogClock::UseTsc()) {
+    return 1.0;
+  }
+  // 自旋约 2ms 得到初始值，之后每次重新校准时用更长的间隔修正
+  uint64_t tick0 = LogClock::NowTicks();
+  int64_t mono0 = MonotonicNs();
+  int64_t mono1 = mono0;
+  while (mono1 - mono0 < 2000000) {
+    mono1 = MonotonicNs();
+  }
+  uint64_t tick1 = LogClock::NowTicks();
+  return static_cast<double>(mono1 - mono0) / static_cast<double>(tick1 - tick0);
+#else
+  // 原始计数本身就是单调时钟的纳秒数
+  return 1.0;
+#endif
+}
+
+double InitialNsPerTick() {
+  static const double ns_per_tick = MeasureNsPerTick();
+  return ns_per_tick;
+}
+
+// 线程局部的校准点
+struct Anchor {
+  uint64_t ticks = 0;
+  int64_t mono_ns = 0;
+  int64_t wall_ns = 0;
+  double ns_per_tick = 0.0;
+};
+
+constexpr int64_t kRecalibrateNs = 1000000000;
+
+void Recalibrate(Anchor* anchor) {
+  uint64_t ticks = LogClock::NowTicks();
+  int64_t mono_ns = MonotonicNs();
+  int64_t wall_ns = RealtimeNs();
+  if (anchor->ns_per_tick == 0.0) {
+    anchor->ns_per_tick = InitialNsPerTick();
+  } else if (ticks > anchor->ticks && mono_ns - anchor->mono_ns >= kRecalibrateNs / 10) {
+    anchor->ns_per_tick = static_cast<double>(mono_ns - anchor->mono_ns) / static_cast<double>(ticks - anchor->ticks);
+  }
+  anchor->ticks = ticks;
+  anchor->mono_ns = mono_ns;
+  anchor->wall_ns = wall_ns;
+}
+}  // namespace
+
+bool LogClock::HasInvariantTsc() noexcept {
+#ifdef LOGGER_CLOCK_USE_TSC
+#if defined(_M_X64)
+  int regs[4] = {0};
+  __cpuid(regs, 0x80000000);
+  if (static_cast<unsigned int>(regs[0]) < 0x80000007) {
+    return false;
+  }
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#else
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  // __get_cpuid 会先检查最大扩展功能号，不支持该功能号时返回 0
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (edx & (1u << 8)) != 0;
+#endif
+#else
+  return false;
+#endif
+}
+
+int64_t LogClock::TicksToWallNs(uint64_t ticks) {
+  static thread_local Anchor anchor;
+  // 日志可能早于或晚于校准点(如在后台线程格式化)，因此按有符号差值计算
+  int64_t delta_ns = static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - anchor.ticks)) *
+                                          anchor.ns_per_tick);
+  if (anchor.ns_per_tick == 0.0 || delta_ns > kRecalibrateNs || delta_ns < -kRecalibrateNs) {
+    Recalibrate(&anchor);
+    delta_ns = static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - anchor.ticks)) *
+                                    anchor.ns_per_tick);
+  }
+  return anchor.wall_ns + delta_ns;
+}
+}  // namespace logger
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if !defined(LOGGER_DISABLE_TSC) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+#define LOGGER_CLOCK_USE_TSC
+#if defined(_M_X64)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace logger {
+/// @brief 日志时间戳：热路径上只读取原始计数，换算为墙上时间推迟到格式化时进行
+/// x86 上 CPU 支持 invariant TSC 时使用 TSC(可定义 LOGGER_DISABLE_TSC 关闭)，否则使用单调时钟的纳秒数
+class LogClock {
+ public:
+  /// @brief 获取原始计数，不涉及系统调用
+  /// @return
+  static uint64_t NowTicks() noexcept {
+#ifdef LOGGER_CLOCK_USE_TSC
+    if (UseTsc()) {
+      return __rdtsc();
+    }
+#endif
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  /// @brief 原始计数是否来自 TSC，进程内只检测一次
+  /// 没有 invariant TSC 时频率会随变频、休眠变化，且各核之间不同步，不能作为时间戳
+  /// @return
+  static bool UseTsc() noexcept {
+#ifdef LOGGER_CLOCK_USE_TSC
+    static const bool use_tsc = HasInvariantTsc();
+    return use_tsc;
+#else
+    return false;
+#endif
+  }
+
+  /// @brief 将原始计数换算为自 epoch 以来的纳秒数
+  /// 每个线程保存一个校准点(原始计数与墙上时间的对应关系)，距离校准点超过一秒才重新校准
+  /// @param ticks
+  /// @return
+  static int64_t TicksToWallNs(uint64_t ticks);
+
+  /// @brief 将原始计数换算为自 epoch 以来的毫秒数
+  /// @param ticks
+  /// @return
+  static int64_t TicksToWallMs(uint64_t ticks) { return TicksToWallNs(ticks) / 1000000; }
+
+ private:
+  /// @brief 通过 CPUID 0x80000007 EDX 第 8 位检测 invariant TSC
+  /// @return
+  static bool HasInvariantTsc() noexcept;
+};
+}  // namespace logger
@@ -0,0 +1,146 @@
+#include "log_file_index.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace logger {
+namespace fs {
+// 索引文件的第一行，之后每行为 "size mtime filename"
+static constexpr const char* kIndexVersion = "tlog-index 1";
+
+static int64_t NowTicks() {
+  return std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+}
+
+void LogFileIndex::Load(const std::filesystem::path& dir, const std::filesystem::path& index_path) {
+  index_path_ = index_path;
+  entries_.clear();
+  names_.clear();
+  total_size_ = 0;
+  if (!index_path_.empty() && LoadIndexFile_(dir)) {
+    return;
+  }
+  // 索引文件不完整时丢弃已读入的部分
+  entries_.clear();
+  names_.clear();
+  total_size_ = 0;
+  Scan_(dir);
+}
+
+bool LogFileIndex::LoadIndexFile_(const std::filesystem::path& dir) {
+  std::ifstream ifs(index_path_);
+  std::string line;
+  if (!ifs || !std::getline(ifs, line) || line != kIndexVersion) {
+    return false;
+  }
+  Entry entry;
+  std::string name;
+  while (ifs >> entry.size >> entry.mtime) {
+    ifs.get();
+    if (!std::getline(ifs, name) || name.empty()) {
+      return false;
+    }
+    entry.path = dir / name;
+    Push_(entry);
+  }
+  if (!ifs.eof()) {
+    return false;
+  }
+  // 索引只在轮转、淘汰时保存，最新的文件之后可能还有写入
+  if (!entries_.empty()) {
+    std::error_code ec;
+    Entry& newest = entries_.back();
+    size_t size = std::filesystem::file_size(newest.path, ec);
+    if (!ec) {
+      total_size_ = total_size_ - newest.size + size;
+      newest.size = size;
+    }
+  }
+  return true;
+}
+
+void LogFileIndex::Scan_(const std::filesystem::path& dir) {
+  std::vector<Entry> files;
+  std::error_code ec;
+  for (auto& p : std::filesystem::directory_iterator(dir, ec)) {
+    if (p.path().extension() != ".log") {
+      continue;
+    }
+    Entry entry;
+    entry.path = p.path();
+    entry.size = p.file_size(ec);
+    entry.mtime = p.last_write_time(ec).time_since_epoch().count();
+    files.push_back(std::move(entry));
+  }
+  std::sort(files.begin(), files.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.mtime < rhs.mtime; });
+  for (auto& entry : files) {
+    Push_(std::move(entry));
+  }
+}
+
+bool LogFileIndex::Save() const {
+  if (index_path_.empty()) {
+    return true;
+  }
+  // 先写临时文件再重命名，进程退出时不会留下不完整的索引
+  auto tmp_path = index_path_;
+  tmp_path += ".tmp";
+  {
+    std::ofstream ofs(tmp_path, std::ios::out | std::ios::trunc);
+    ofs << kIndexVersion << '\n';
+    for (const auto& entry : entries_) {
+      ofs << entry.size << ' ' << entry.mtime << ' ' << entry.path.filename().string() << '\n';
+    }
+    if (!ofs) {
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, index_path_, ec);
+  return !ec;
+}
+
+bool LogFileIndex::Touch(const std::filesystem::path& path, size_t size) {
+  int64_t now = NowTicks();
+  if (!entries_.empty() && entries_.back().path == path) {
+    total_size_ = total_size_ - entries_.back().size + size;
+    entries_.back().size = size;
+    entries_.back().mtime = now;
+    return false;
+  }
+  bool is_new = !Contains(path);
+  if (!is_new) {
+    auto name = path.filename();
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&name](const Entry& entry) { return entry.path.filename() == name; });
+    total_size_ -= it->size;
+    names_.erase(it->path.filename().string());
+    entries_.erase(it);
+  }
+  Entry entry;
+  entry.path = path;
+  entry.size = size;
+  entry.mtime = now;
+  Push_(std::move(entry));
+  return is_new;
+}
+
+std::vector<std::filesystem::path> LogFileIndex::Evict(size_t limit) {
+  std::vector<std::filesystem::path> evicted;
+  while (total_size_ > limit && !entries_.empty()) {
+    Entry& oldest = entries_.front();
+    total_size_ -= oldest.size;
+    names_.erase(oldest.path.filename().string());
+    evicted.push_back(std::move(oldest.path));
+    entries_.pop_front();
+  }
+  return evicted;
+}
+
+void LogFileIndex::Push_(Entry entry) {
+  total_size_ += entry.size;
+  names_.insert(entry.path.filename().string());
+  entries_.push_back(std::move(entry));
+}
+}  // namespace fs
+}  // namespace logger
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace logger {
+namespace fs {
+/// @brief 在内存中记录日志目录下的日志文件及其大小，按修改时间从旧到新排列
+/// 启动时建立一次，之后由写入者在每次写入、轮转时更新，轮转和淘汰不再遍历目录、查询文件状态
+class LogFileIndex {
+ public:
+  struct Entry {
+    std::filesystem::path path;
+    size_t size = 0;
+    int64_t mtime = 0;  // file_time_type 的计数，只用于排序
+  };
+
+  /// @brief 从索引文件建立索引，索引文件不存在或损坏时遍历目录
+  /// @param dir 日志目录，其中扩展名为 .log 的文件都会计入
+  /// @param index_path 索引文件路径，为空表示不保存索引文件
+  void Load(const std::filesystem::path& dir, const std::filesystem::path& index_path);
+
+  /// @brief 将索引写入索引文件，未指定索引文件时不做任何操作
+  /// @return
+  bool Save() const;
+
+  /// @brief 记录一次写入，文件不是最新的一个时移到末尾
+  /// @param path
+  /// @param size 写入后的文件大小
+  /// @return 是否为新加入的文件
+  bool Touch(const std::filesystem::path& path, size_t size);
+
+  bool Contains(const std::filesystem::path& path) const { return names_.count(path.filename().string()) != 0; }
+
+  size_t TotalSize() const noexcept { return total_size_; }
+
+  size_t Count() const noexcept { return entries_.size(); }
+
+  /// @brief 从最旧的文件开始移出索引，直到总大小不超过 limit
+  /// @param limit
+  /// @return 移出的文件，由调用者删除
+  std::vector<std::filesystem::path> Evict(size_t limit);
+
+ private:
+  /// @brief 解析索引文件
+  /// @param dir
+  /// @return 索引文件不存在或格式错误时返回 false
+  bool LoadIndexFile_(const std::filesystem::path& dir);
+
+  /// @brief 遍历目录建立索引，每个文件只查询一次状态
+  /// @param dir
+  void Scan_(const std::filesystem::path& dir);
+
+  void Push_(Entry entry);
+
+ private:
+  std::filesystem::path index_path_;
+  std::deque<Entry> entries_;
+  std::unordered_set<std::string> names_;  // entries_ 中的文件名
+  size_t total_size_ = 0;
+};
+}  // namespace fs
+}  // namespace logger
@@ -7,6 +7,8 @@ size_t GetPageSize();
 
 void LocalTime(std::tm* tm, std::time_t* now);
 
+// 首次调用后缓存，fork 后自动刷新
 size_t GetProcessId();
 
+// 每个线程首次调用后缓存，fork 后自动刷新
 size_t GetThreadId();
\ No newline at end of file
@@ -1,6 +1,24 @@
 #include "sys_util.h"
 
+#include <pthread.h>
 #include <unistd.h>
+
+#include <atomic>
+
+namespace {
+// 进程 id 与线程 id 在首次获取后缓存，fork 后由子进程回调清除
+std::atomic<size_t> g_process_id{0};
+thread_local size_t t_thread_id = 0;
+
+void ResetIdentityInChild() {
+  // 子进程中只存在调用 fork 的线程，回调即在该线程上执行
+  g_process_id.store(0, std::memory_order_relaxed);
+  t_thread_id = 0;
+}
+
+const int g_atfork_registered = pthread_atfork(nullptr, nullptr, ResetIdentityInChild);
+}  // namespace
+
 // 获取 Linux 下的 页 大小
 size_t GetPageSize() {
   return getpagesize();
@@ -11,9 +29,17 @@ void LocalTime(std::tm* tm, std::time_t* now) {
 }
 
 size_t GetProcessId() {
-  return static_cast<size_t>(::getpid());
+  size_t pid = g_process_id.load(std::memory_order_relaxed);
+  if (pid == 0) {
+    pid = static_cast<size_t>(::getpid());
+    g_process_id.store(pid, std::memory_order_relaxed);
+  }
+  return pid;
 }
 
 size_t GetThreadId() {
-  return static_cast<size_t>(::gettid());
-}
\ No newline at end of file
+  if (t_thread_id == 0) {
+    t_thread_id = static_cast<size_t>(::gettid());
+  }
+  return t_thread_id;
+}
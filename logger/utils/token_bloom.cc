@@ -0,0 +1,52 @@
+#include "token_bloom.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace logger {
+static constexpr size_t kBitsPerToken = 8;
+static constexpr uint32_t kMaxProbes = 5;
+static constexpr size_t kMinBloomSize = 64;
+
+// 由一个 64 位哈希的高低两半组合出 probes 个位置
+template <typename F>
+static void ForEachProbe(uint64_t hash, uint32_t probes, uint64_t bits, F&& f) {
+  uint64_t h1 = hash & 0xffffffff;
+  uint64_t h2 = (hash >> 32) | 1;
+  for (uint32_t i = 0; i < probes; ++i) {
+    f((h1 + i * h2) % bits);
+  }
+}
+
+std::string BuildTokenBloom(std::vector<uint64_t>* hashes, size_t max_size) {
+  std::sort(hashes->begin(), hashes->end());
+  hashes->erase(std::unique(hashes->begin(), hashes->end()), hashes->end());
+  size_t size = (hashes->size() * kBitsPerToken / 8 + 7) / 8 * 8;
+  size = std::max(kMinBloomSize, std::min(size, max_size / 8 * 8));
+  uint64_t bits = size * 8;
+  // 每个词分到的位数为 m/n 时，探测次数取 m/n*ln2 误判率最低
+  double bits_per_token = static_cast<double>(bits) / static_cast<double>(std::max<size_t>(hashes->size(), 1));
+  auto probes = static_cast<uint32_t>(std::lround(bits_per_token * 0.693));
+  probes = std::max<uint32_t>(1, std::min(probes, kMaxProbes));
+  std::string bloom(size + 1, '\0');
+  bloom[0] = static_cast<char>(probes);
+  char* data = bloom.data() + 1;
+  for (uint64_t hash : *hashes) {
+    ForEachProbe(hash, probes, bits, [data](uint64_t bit) { data[bit / 8] |= static_cast<char>(1 << (bit % 8)); });
+  }
+  return bloom;
+}
+
+bool TokenBloomMayContain(const char* bloom, size_t size, uint64_t hash) {
+  if (size < 2) {
+    return true;
+  }
+  auto probes = static_cast<uint8_t>(bloom[0]);
+  const char* data = bloom + 1;
+  bool found = true;
+  ForEachProbe(hash, probes, (size - 1) * 8, [data, &found](uint64_t bit) {
+    found = found && (static_cast<uint8_t>(data[bit / 8]) >> (bit % 8) & 1) != 0;
+  });
+  return found;
+}
+}  // namespace logger
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "log_common.h"
+
+namespace logger {
+// 短于该长度的词不写入过滤器，查询中的短词只在解码后比较
+constexpr size_t kMinBloomTokenSize = 3;
+
+inline bool IsTokenChar(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '-';
+}
+
+/// @brief 依次取出 text 中的词，词为连续的字母、数字、'_'、'-'，区分大小写
+/// @param text
+/// @param f 以 StringView 调用
+template <typename F>
+void ForEachToken(StringView text, F&& f) {
+  size_t i = 0;
+  while (i < text.size()) {
+    while (i < text.size() && !IsTokenChar(text[i])) {
+      ++i;
+    }
+    size_t begin = i;
+    while (i < text.size() && IsTokenChar(text[i])) {
+      ++i;
+    }
+    if (i > begin) {
+      f(text.substr(begin, i - begin));
+    }
+  }
+}
+
+/// @brief 由词哈希生成 Bloom 过滤器，每个不同的词约占 8 位，误判率约 2%
+/// 词过多时大小不超过 max_size，并相应减少探测次数，误判率随之上升
+/// @param hashes 排序去重后用于计算大小
+/// @param max_size
+/// @return 第一个字节为探测次数，之后为位数组
+std::string BuildTokenBloom(std::vector<uint64_t>* hashes, size_t max_size);
+
+/// @brief 过滤器中是否可能有该词
+/// @param bloom BuildTokenBloom 生成的数据
+/// @param size
+/// @param hash
+/// @return 返回 false 时一定没有
+bool TokenBloomMayContain(const char* bloom, size_t size, uint64_t hash);
+}  // namespace logger